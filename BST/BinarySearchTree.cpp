@@ -8,10 +8,16 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
 #include <ctime>
 #include <string>
+#include <string_view>
 
 #include "CSVparser.cpp"
+#include "BloomFilter.h"
 
 using namespace std;
 
@@ -21,9 +27,6 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch); //took me a while to solve, but this requires #include <algorithm>
-
 // define a structure to hold bid information
 struct Bid {
     /* The CSV contains the following fields:
@@ -52,16 +55,21 @@ struct Bid {
     }
 };
 
+// what gets loaded from the CSV: id, title, fund and winning bid (columns 1, 0, 8 and 4)
+const vector<csv::ColumnSpec> BID_COLUMNS = {{1}, {0}, {8}, {4, csv::eMONEY}};
+
 // Internal structure for tree node
 struct Node {
     Bid bid;
     Node *left;
     Node *right;
+    int height; // longest path down to a leaf, counting this node, for the AVL balancing
 
     // default constructor
     Node() {
         left = nullptr;
         right = nullptr;
+        height = 1;
     }
 
     // initialize with a bid
@@ -71,6 +79,30 @@ struct Node {
     }
 };
 
+//============================================================================
+// Tree interface
+//============================================================================
+
+/**
+ * What main() and loadBids() need from a tree of bids, so the menu works the
+ * same on the binary search tree and the B+ tree
+ *
+ * Both keep every bid they're given. If an id comes up more than once (the
+ * big CSV has a couple), the copies stay in the order they were inserted,
+ * and Search/Find and Remove go by the first one.
+ */
+class BidTree {
+public:
+    virtual ~BidTree() {}
+    virtual void Insert(const Bid& bid) = 0;
+    virtual void Remove(const string& bidId) = 0;
+    virtual Bid Search(const string& bidId) = 0;
+    virtual const Bid* Find(string_view bidId) const = 0;
+    virtual void InOrder() = 0;
+    virtual int Height() const = 0; // levels from the root down to the bottom
+    virtual const BloomFilter* getFilter() const { return nullptr; }
+};
+
 //============================================================================
 // Binary Search Tree class definition
 //============================================================================
@@ -78,77 +110,94 @@ struct Node {
 /**
  * Define a class containing data members and methods to
  * implement a binary search tree
+ *
+ * By default it's an AVL tree: every node knows its height, and after an
+ * insert or remove the nodes on the way back up get rotated whenever one side
+ * is two taller than the other. The CSVs come sorted by id, which without
+ * balancing turns the tree into one long list.
  */
-class BinarySearchTree {
+class BinarySearchTree : public BidTree {
 
 private:
     Node* root;
-
-    void addNode(Node* node, const Bid& bid);
+    bool balanced; // false gives the plain, never rebalanced tree (for comparing)
+    vector<Node**> path; // the links addNode/removeNode walked down, kept between calls to save allocating it
+    unique_ptr<BloomFilter> filter; // optional, lets Find skip the walk down the tree for most missing bids
+
+    Node* addNode(Node* node, const Bid& bid);
+    static int height(const Node* node) { return node != nullptr ? node->height : 0; }
+    static void updateHeight(Node* node);
+    static Node* rotateLeft(Node* node);
+    static Node* rotateRight(Node* node);
+    Node* rebalance(Node* node);
     void inOrder(Node* node);
     void postOrder(Node* node);   //I added forward declarations here for lowercase post and preOrder
     void preOrder(Node* node);
-    Node* removeNode(Node* node, const string& bidId);
-    void removeSubtree(Node* node); //I'm going to use this recursively for the destructor
+    Node* removeNode(Node* node, string_view bidId);
+    void removeSubtree(Node* node); //the destructor uses this to delete every node
+    size_t countNodes(const Node* node) const;
+    void addToFilter(const Node* node);
 
 public:
-    BinarySearchTree();
+    explicit BinarySearchTree(bool balance = true);
     virtual ~BinarySearchTree();
-    void InOrder();
+    void InOrder() override;
     void PostOrder();       //added forward decs here for upper case Post and PreOrder...
     void PreOrder();
-    void Insert(const Bid& bid);
-    void Remove(const string& bidId);
-    Bid Search(const string& bidId);
+    void Insert(const Bid& bid) override;
+    void Remove(const string& bidId) override;
+    Bid Search(const string& bidId) override;
+    const Bid* Find(string_view bidId) const override;
+    bool Erase(string_view bidId);
+    void enableFilter(double bitsPerKey = 10);
+    void rebuildFilter();
+    const BloomFilter* getFilter() const override { return filter.get(); }
+    int Height() const override { return height(root); }
 };
 
 /**
  * Default constructor
+ *
+ * @param balance false to never rebalance, like the tree used to be
  */
-BinarySearchTree::BinarySearchTree() {
+BinarySearchTree::BinarySearchTree(bool balance) {
     //root is equal to nullptr
     root = nullptr;
+    balanced = balance;
 }
 
 /**
  * Destructor
  */
 BinarySearchTree::~BinarySearchTree() {
-    // recurse from root deleting every node
+    // delete every node, starting from root
     //Got some help from this video: https://www.youtube.com/watch?v=ozBhVQNSJ9E
     if (root != nullptr) {
         removeSubtree(root);
     }
 }
 
-//recursive helper for destructor:
+//helper for destructor:
 void BinarySearchTree::removeSubtree(Node* node) {
-    if(node->left != nullptr) {
-        removeSubtree(node->left); //this will recursively drill down the left-most subtree
-    }
-
-    if(node->right != nullptr) {
-        removeSubtree(node->right);
-    }
-
-    //if we've made it this far, then we've gone as far left and as far right as possible
-    //delete the current node, then allow the recursion to unwind and delete trace the parent's right subtree
-    //if no right subtree exists, then delete that node and unwind a further level up the tree towards the root
-
-    //cout << "Deleting node with key: " << node->bid.bidId << endl;
-    delete node;
-
-    /****
-    if (node != nullptr) {
-        //if the node that gets passed exists...
-        // Recursively delete left and right subtrees... these will drill down the subtrees until reaching nullptr
-        removeSubtree(node->left);
-        removeSubtree(node->right);
+    //this used to recurse down the left and right subtrees and delete on the way back up,
+    //but a tree built from sorted bids (without balancing) is one long line, and that many
+    //nested calls runs out of stack. Now there's no recursion and no stack at all:
+    //while the node on top has a left child, rotate right so the left child comes up on top,
+    //and once it has none, delete it and carry on with its right subtree.
+    while (node != nullptr) {
+        if (node->left != nullptr) {
+            Node* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            Node* right = node->right;
 
-        // Delete the current node
-        delete node;
+            //cout << "Deleting node with key: " << node->bid.bidId << endl;
+            delete node;
+            node = right;
+        }
     }
-    ****/
 }
 
 /**
@@ -179,14 +228,76 @@ void BinarySearchTree::PreOrder() {
  * Insert a bid
  */
 void BinarySearchTree::Insert(const Bid& bid) {
-    // if root equal to null ptr
-    if (root == nullptr) {
-        // root is equal to new node bid
-        root = new Node(bid);
+    // add Node root and bid
+    //(addNode makes the root too if the tree is empty, and hands back the root, which a rotation may have changed)
+    root = addNode(root, bid);
+
+    if (filter) {
+        filter->add(bid.bidId);
+        if (filter->overfull()) {
+            rebuildFilter();
+        }
     }
-    else {
-        // add Node root and bid
-        addNode(root, bid);
+}
+
+/**
+ * Put a Bloom filter in front of Find, filled with the bids already in the tree
+ *
+ * @param bitsPerKey filter memory per bid it has room for, 10 bits is about a 1% false positive rate
+ */
+void BinarySearchTree::enableFilter(double bitsPerKey) {
+    filter.reset(new BloomFilter(0, bitsPerKey));
+    rebuildFilter();
+}
+
+/**
+ * Refill the filter from the tree, sized for twice the bids in it.
+ * Removed bids keep getting "maybe" from the filter until this runs.
+ */
+void BinarySearchTree::rebuildFilter() {
+    if (!filter) {
+        return;
+    }
+    filter->reset(countNodes(root) * 2);
+    addToFilter(root);
+}
+
+//helpers for rebuildFilter(), the order doesn't matter so they go pre-order with a stack, like preOrder()
+size_t BinarySearchTree::countNodes(const Node* node) const {
+    size_t count = 0;
+    vector<const Node*> stack;
+    if (node != nullptr) {
+        stack.push_back(node);
+    }
+    while (!stack.empty()) {
+        node = stack.back();
+        stack.pop_back();
+        ++count;
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
+    }
+    return count;
+}
+
+void BinarySearchTree::addToFilter(const Node* node) {
+    vector<const Node*> stack;
+    if (node != nullptr) {
+        stack.push_back(node);
+    }
+    while (!stack.empty()) {
+        node = stack.back();
+        stack.pop_back();
+        filter->add(node->bid.bidId);
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
     }
 }
 
@@ -198,56 +309,83 @@ void BinarySearchTree::Remove(const string& bidId) {
     root = removeNode(root, bidId);
 }
 
-//helper method for Remove()
-Node* BinarySearchTree::removeNode(Node* node, const string& bidId) {
-    // If the node is null, then the node with the bidID could not be found in the string.
-    if (node == nullptr) {
-        return nullptr;
+/**
+ * Remove a bid, and say whether it was there
+ *
+ * @param bidId The bid id to remove
+ * @return true if it was in the tree
+ */
+bool BinarySearchTree::Erase(string_view bidId) {
+    if (Find(bidId) == nullptr) {
+        return false;
     }
+    root = removeNode(root, bidId);
+    return true;
+}
 
-    //function will recursive traverse down left or down right,
-    // depending on if the target bidID is less than or greater than the bidID in the current node
-
-    // If target bidId is less than the current node's bidId, go left
-    if (bidId < node->bid.bidId) {
-        node->left = removeNode(node->left, bidId);
-    } else if (bidId > node->bid.bidId) {
-        // If target bidId is greater than the current node's bidId, go right
-        node->right = removeNode(node->right, bidId);
-    } else {
-        //neither greater than nor less than, therefore equals... therefore this is the target node to delete!
-        //and we're assuming bidIDs are unique!
+//helper method for Remove()
+Node* BinarySearchTree::removeNode(Node* node, string_view bidId) {
+    //this used to call itself on the left or right subtree, now it walks down in a loop instead
+    //(a long unbalanced tree made for a lot of nested calls). "link" is the pointer that points at
+    //the node we're looking at: node itself to start with, then some node's left or right.
+    //Every link on the way down goes in "path", so the nodes above can be rebalanced afterwards.
+    path.clear();
+    Node** link = &node;
 
-        // Case 1: Node with only one child or no child
-        if (node->left == nullptr) {
-            //left child doesn't exist, so we will pop up the right child and then delete the current node.
-            Node* temp = node->right;
-            delete node;
-            return temp;
-        } else if (node->right == nullptr) {
-            //same same but right doesn't exist... pop left
-            Node* temp = node->left;
-            delete node;
-            return temp;
+    // depending on if the target bidID is less than or greater than the bidID in the current node
+    // go left or right, all the way to the bottom. Same as Find(): a match might have an earlier
+    // copy of the bid further down on its left, and it's the first copy that gets removed
+    Node** found = nullptr;
+    size_t foundDepth = 0;
+    while (*link != nullptr) {
+        if ((*link)->bid.bidId == bidId) {
+            found = link;
+            foundDepth = path.size();
         }
+        path.push_back(link);
+        // If target bidId is less than (or the same as) the current node's bidId, go left, if it's greater, go right
+        link = bidId <= (*link)->bid.bidId ? &(*link)->left : &(*link)->right;
+    }
+    if (found == nullptr) {
+        return node;
+    }
 
+    //neither greater than nor less than, therefore equals... therefore this is the target node to delete!
+    //only the nodes above it need rebalancing, so the rest of the path goes
+    link = found;
+    path.resize(foundDepth);
+    Node* target = *link;
+
+    // Case 1: Node with only one child or no child
+    if (target->left == nullptr || target->right == nullptr) {
+        //whichever child exists (or nullptr) gets popped up into the target's place, then delete the target
+        *link = target->left != nullptr ? target->left : target->right;
+        delete target;
+    } else {
         // Case 2: Node with two children
         // Get the inorder successor (smallest in the right subtree, aka left-most in the right subtree)
-        Node* temp = node->right;
-        //I wanted to use the existing inOrder() method but that's a void...
-        //would need to create a new helper method just for this method... nah let's just insert logic here.
-        while (temp->left != nullptr) {
-            temp = temp->left;
+        path.push_back(link); //the target node stays, its right subtree changes under it
+        Node** successor = &target->right;
+        while ((*successor)->left != nullptr) {
+            path.push_back(successor);
+            successor = &(*successor)->left;
         }
 
-        // Copy the inorder successor's content to this node
+        // Move the inorder successor's content to this node
         //this step is crucial, it ensuures that the BST still maintains order
-        node->bid = temp->bid;
+        Node* temp = *successor;
+        target->bid = std::move(temp->bid);
 
         // Delete the inorder successor...
         //really, we are replacing the target node (for deletion) with its inorder successor
-        //this way, there are no duplicate nodes in the BST
-        node->right = removeNode(node->right, temp->bid.bidId);
+        //this way, there are no duplicate nodes in the BST. It has no left child, so its right one takes its place
+        *successor = temp->right;
+        delete temp;
+    }
+
+    //back up the path, fix the heights and rotate wherever a node got lopsided
+    for (size_t i = path.size(); i-- > 0;) {
+        *path[i] = rebalance(*path[i]);
     }
 
     return node;
@@ -260,21 +398,47 @@ Node* BinarySearchTree::removeNode(Node* node, const string& bidId) {
  */
 Bid BinarySearchTree::Search(const string& bidId) {
     //made bidId a constant reference to avoid copying it every invocation
+    //the walk down the tree is in Find(), this just makes the copy (or the empty bid)
+    const Bid* found = Find(bidId);
+    if (found != nullptr) {
+        return *found;
+    }
+
+    //if we get this far, it means Find never hit "return &current->bid;"
+    Bid emptyBid;
+    return emptyBid;
+}
+
+/**
+ * Search for a bid without copying it
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or nullptr if it isn't in the tree. Only good until the tree changes.
+ */
+const Bid* BinarySearchTree::Find(string_view bidId) const {
+    // the filter knows for sure when a bid was never inserted, no need to walk the tree then
+    if (filter && !filter->mayContain(bidId)) {
+        return nullptr;
+    }
 
     // set current node equal to root
-    Node* current = root;
+    const Node* current = root;
 
 
 
-    // keep looping downwards until bottom reached or matching bidId found
+    // keep looping downwards until bottom reached
+    //a repeated id always goes in to the right of the copies already there, and rotations don't change
+    //the left-to-right order, so the first copy is the left-most one. A match might still have an
+    //earlier copy down to its left (a rotation can lift a later copy above it), so remember it and keep going left
+    const Bid* found = nullptr;
     while (current != nullptr) {
-        // if match found, return current bid
+        // if match found, remember current bid
         if (current->bid.bidId == bidId) {
-            return current->bid;
+            found = &current->bid;
         }
 
-        // if bid is smaller than current node then traverse left
-        if (bidId < current->bid.bidId) {
+        // if bid is smaller than (or the same as) current node then traverse left
+        if (bidId <= current->bid.bidId) {
             current = current->left;
         }
         else {// else larger so traverse right
@@ -282,70 +446,707 @@ Bid BinarySearchTree::Search(const string& bidId) {
         }
     }
 
-    //if we get this far, it means we never hit "return current->bid;"
-    Bid emptyBid;
-    return emptyBid;
+    return found;
 }
 
 /**
- * Add a bid to some node (recursive)
+ * Add a bid to some subtree
  *
  * @param node Current node in tree
  * @param bid Bid to be added
+ * @return the subtree's top node, which a rotation may have changed
  */
-void BinarySearchTree::addNode(Node* node, const Bid& bid) {
+Node* BinarySearchTree::addNode(Node* node, const Bid& bid) {
     //"bid" is the new thing we want to add
-    //I made it constant to avoid copying it with every recursive call
+    //I made it constant to avoid copying it
+
+    //"node" is the subtree we are adding to. This used to call itself on the left or right child,
+    //now it's a loop: "link" is the pointer that points at the node we're looking at, and every
+    //link on the way down goes in "path" so the nodes above can be rebalanced afterwards
+    path.clear();
+    Node** link = &node;
+    while (*link != nullptr) {
+        path.push_back(link);
+        // if node is larger then add to left
+        if ((*link)->bid.bidId > bid.bidId) {
+            link = &(*link)->left;
+        }
+        else {//the new bidID is greater, or equal to, the existing node... go right
+            link = &(*link)->right;
+        }
+    }
 
-    //"node" is the address of a node we are contemplating adding to
-    // if node is larger then add to left
-    if(node->bid.bidId > bid.bidId)
+    //once we fall off the bottom of the tree, this is where the bid goes
+    *link = new Node(bid);
 
-        if (node->left == nullptr) {// if no left node (left child is null)
-            // this "bid" becomes left node...create new node containing the bid
-            node->left = new Node(bid);
-        }
-        else {// else recurse down the left node
-            //left node is not null, so need to decide whether bid should go left or right of that left child
-            addNode(node->left, bid);
+    //back up the path: fix the heights and rotate wherever a node got lopsided. Once a subtree
+    //comes out the same height it was (after a rotation it always does), nothing above it changes
+    for (size_t i = path.size(); i-- > 0;) {
+        int height = (*path[i])->height;
+        *path[i] = rebalance(*path[i]);
+        if ((*path[i])->height == height) {
+            break;
         }
-    else {//the new bidID is greater, or equal to, the existing node... go right
+    }
 
-        if (node->right == nullptr) {// if no right node...
-            //if right child is null, insert new bid as right child
-            node->right = new Node(bid);
-        } else {
-            // recurse down the right subtree
-            addNode(node->right, bid);
+    return node;
+}
+
+void BinarySearchTree::updateHeight(Node* node) {
+    node->height = 1 + max(height(node->left), height(node->right));
+}
+
+//node's right child moves up into its place, node becomes that child's left child,
+//and the child's old left subtree (everything between the two) becomes node's right subtree
+Node* BinarySearchTree::rotateLeft(Node* node) {
+    Node* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updateHeight(node);
+    updateHeight(right);
+    return right;
+}
+
+//mirror image of rotateLeft
+Node* BinarySearchTree::rotateRight(Node* node) {
+    Node* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updateHeight(node);
+    updateHeight(left);
+    return left;
+}
+
+//helper for addNode() and removeNode(): fix node's height after one of its subtrees changed,
+//and rotate if the two sides now differ by 2. Returns whatever ends up on top.
+Node* BinarySearchTree::rebalance(Node* node) {
+    updateHeight(node);
+    if (!balanced) {
+        return node;
+    }
+
+    int balance = height(node->left) - height(node->right);
+    if (balance > 1) {
+        //left heavy... if the left child leans right, straighten that out first (left-right case)
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        //right heavy, same thing mirrored
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(node->right);
         }
+        return rotateLeft(node);
     }
+    return node;
 }
 void BinarySearchTree::inOrder(Node* node) {
-    //if node is not equal to null ptr
-    if (node != nullptr) {
-        inOrder(node->left);
+    //Morris traversal: no recursion and no stack. Before going down into a left subtree, the
+    //right-most node in it gets its (empty) right pointer aimed back at "node", that's how we
+    //find our way back up when the subtree is done. The second time we get there we take it out again.
+    while (node != nullptr) {
+        if (node->left != nullptr) {
+            Node* predecessor = node->left;
+            while (predecessor->right != nullptr && predecessor->right != node) {
+                predecessor = predecessor->right;
+            }
+            if (predecessor->right == nullptr) {
+                //first visit: leave the way back, then go do the left subtree
+                predecessor->right = node;
+                node = node->left;
+                continue;
+            }
+            //second visit: the left subtree is done, put the tree back the way it was
+            predecessor->right = nullptr;
+        }
 
         //output bidID, title, amount, fund
         cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | " << node->bid.fund << endl;
 
-        inOrder(node->right);
+        node = node->right;
     }
 }
 void BinarySearchTree::postOrder(Node* node) {
-    if (node != nullptr) {
-        postOrder(node->left);
-        postOrder(node->right);
-        //output bidID, title, amount, fund
-        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | " << node->bid.fund << endl;
+    //with a stack of the nodes still waiting on their subtrees, instead of recursion
+    vector<Node*> stack;
+    Node* last = nullptr; //the node printed last, so we can tell whether a right subtree is done
+    while (node != nullptr || !stack.empty()) {
+        if (node != nullptr) {
+            stack.push_back(node);
+            node = node->left;
+        } else if (stack.back()->right != nullptr && stack.back()->right != last) {
+            node = stack.back()->right;
+        } else {
+            last = stack.back();
+            stack.pop_back();
+            //output bidID, title, amount, fund
+            cout << last->bid.bidId << ": " << last->bid.title << " | " << last->bid.amount << " | " << last->bid.fund << endl;
+        }
     }
 }
 
 void BinarySearchTree::preOrder(Node* node) {
+    //with a stack of the subtrees still to do, instead of recursion (right goes on first so left comes off first)
+    vector<Node*> stack;
     if (node != nullptr) {
+        stack.push_back(node);
+    }
+    while (!stack.empty()) {
+        node = stack.back();
+        stack.pop_back();
         //output bidID, title, amount, fund
         cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | " << node->bid.fund << endl;
-        preOrder(node->left);
-        preOrder(node->right);
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
+    }
+}
+
+//============================================================================
+// B+ Tree class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a B+ tree keyed on bidId
+ *
+ * The binary tree has one bid per node, so a lookup misses the cache at
+ * nearly every level, and a million bids is twenty-odd levels. Here a node
+ * holds dozens of keys side by side: the bids only live in the leaves, the
+ * inner nodes just route the search, and a million bids is four levels.
+ * Every leaf points at the next one, so going through the bids in order (or
+ * just a range of them) is a walk along the leaves.
+ *
+ * Copies of a repeated id can end up spread over more than one leaf, so the
+ * keys only keep things apart loosely: everything under children[i] is <=
+ * keys[i] <= everything under children[i + 1]. Insert goes down to the last
+ * place the id could go, and Find and Erase to the first.
+ *
+ * Inside a node the search runs over the first 8 bytes of each key packed
+ * into a uint64_t (big-endian, so comparing the numbers compares the strings)
+ * and only compares the actual strings where the prefixes tie. The bid ids
+ * are 5 or 6 digits, so that's only ever the exact match.
+ */
+class BPlusTree : public BidTree {
+
+private:
+    static const int LEAF_SIZE = 32;  // bids per leaf, their prefixes take 4 cache lines
+    static const int INNER_SIZE = 63; // keys per inner node (64 children), the prefixes take 8 cache lines
+    static const int MIN_LEAF = LEAF_SIZE / 2;   // fewer than this after a remove and the leaf borrows or merges
+    static const int MIN_INNER = INNER_SIZE / 2; // same for inner nodes
+
+    struct Leaf {
+        int count = 0;
+        Leaf* next = nullptr; // the leaf to the right, for InOrder and forRange
+        alignas(64) uint64_t prefixes[LEAF_SIZE];
+        Bid bids[LEAF_SIZE];
+    };
+
+    struct Inner {
+        int count = 0; // number of keys, there's one more child than that
+        alignas(64) uint64_t prefixes[INNER_SIZE];
+        void* children[INNER_SIZE + 1]; // Inner* on the levels above the leaves, Leaf* on the one just above them
+        string keys[INNER_SIZE]; // everything under children[i] is <= keys[i] <= everything under children[i + 1]
+    };
+
+    void* root;
+    int levels; // 0 when empty, 1 when the root is a leaf
+    size_t size;
+    vector<pair<Inner*, int>> path; // the inner nodes Insert/Erase walked down, and which child they took
+
+    static uint64_t prefixOf(string_view key);
+    static int lowerBound(const uint64_t* prefixes, int count, uint64_t prefix);
+    static int childIndex(const Inner* node, uint64_t prefix, string_view key, bool last);
+    static int leafIndex(const Leaf* leaf, uint64_t prefix, string_view key, bool last);
+    Leaf* findLeaf(uint64_t prefix, string_view key, bool last);
+    Leaf* nextLeaf();
+    static void insertAt(Leaf* leaf, int i, uint64_t prefix, Bid bid);
+    static void insertKey(Inner* node, int i, uint64_t prefix, string key, void* right);
+    static void removeKey(Inner* node, int i);
+    void splitLeaf(Leaf* leaf, int i, uint64_t prefix, const Bid& bid);
+    void fixUnderflow(Leaf* leaf);
+    void freeNode(void* node, int level);
+
+public:
+    BPlusTree();
+    virtual ~BPlusTree();
+    void InOrder() override;
+    void Insert(const Bid& bid) override;
+    void Remove(const string& bidId) override;
+    Bid Search(const string& bidId) override;
+    const Bid* Find(string_view bidId) const override;
+    bool Erase(string_view bidId);
+    int Height() const override { return levels; }
+    size_t Size() const { return size; }
+
+    /**
+     * Call visit(bid) for every bid with from <= bidId <= to, in order
+     *
+     * Finds from's leaf the same way Find does, then just follows the leaves.
+     */
+    template <typename Visit>
+    void forRange(string_view from, string_view to, Visit visit) const {
+        if (root == nullptr) {
+            return;
+        }
+        uint64_t prefix = prefixOf(from);
+        const void* node = root;
+        for (int level = levels; level > 1; --level) {
+            const Inner* inner = static_cast<const Inner*>(node);
+            node = inner->children[childIndex(inner, prefix, from, false)];
+        }
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        for (int i = leafIndex(leaf, prefix, from, false); leaf != nullptr; leaf = leaf->next, i = 0) {
+            for (; i < leaf->count; ++i) {
+                if (to < leaf->bids[i].bidId) {
+                    return;
+                }
+                visit(leaf->bids[i]);
+            }
+        }
+    }
+};
+
+/**
+ * Default constructor
+ */
+BPlusTree::BPlusTree() {
+    root = nullptr;
+    levels = 0;
+    size = 0;
+}
+
+/**
+ * Destructor
+ */
+BPlusTree::~BPlusTree() {
+    if (root != nullptr) {
+        freeNode(root, levels);
+    }
+}
+
+//helper for destructor, it only goes as deep as the tree has levels (a handful), so recursion is fine here
+void BPlusTree::freeNode(void* node, int level) {
+    if (level == 1) {
+        delete static_cast<Leaf*>(node);
+        return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (int i = 0; i <= inner->count; ++i) {
+        freeNode(inner->children[i], level - 1);
+    }
+    delete inner;
+}
+
+//first 8 bytes of the key, big-endian, padded with zeros (which sort before any character)
+uint64_t BPlusTree::prefixOf(string_view key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        prefix = prefix << 8 | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+    }
+    return prefix;
+}
+
+//first position whose prefix is >= the one given. A binary search without a branch in the loop
+//(the compiler turns the ?: into a conditional move), so there's no mispredict at every step
+int BPlusTree::lowerBound(const uint64_t* prefixes, int count, uint64_t prefix) {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t* base = prefixes;
+    while (count > 1) {
+        int half = count / 2;
+        base = base[half] < prefix ? base + half : base;
+        count -= half;
+    }
+    return static_cast<int>(base - prefixes) + (*base < prefix);
+}
+
+//which child of an inner node to go down: the first one the key could be under (the number of keys < it),
+//or with "last" the last one (the number of keys <= it)
+int BPlusTree::childIndex(const Inner* node, uint64_t prefix, string_view key, bool last) {
+    int i = lowerBound(node->prefixes, node->count, prefix);
+    while (i < node->count && node->prefixes[i] == prefix &&
+           (last ? string_view(node->keys[i]) <= key : string_view(node->keys[i]) < key)) {
+        ++i;
+    }
+    return i;
+}
+
+//where the key's first copy is in a leaf (or where it would go), or with "last" the place just after its last copy
+int BPlusTree::leafIndex(const Leaf* leaf, uint64_t prefix, string_view key, bool last) {
+    int i = lowerBound(leaf->prefixes, leaf->count, prefix);
+    while (i < leaf->count && leaf->prefixes[i] == prefix &&
+           (last ? string_view(leaf->bids[i].bidId) <= key : string_view(leaf->bids[i].bidId) < key)) {
+        ++i;
+    }
+    return i;
+}
+
+//walk down to the first (or with "last", the last) leaf the key could be in, keeping the way down in "path"
+BPlusTree::Leaf* BPlusTree::findLeaf(uint64_t prefix, string_view key, bool last) {
+    path.clear();
+    void* node = root;
+    for (int level = levels; level > 1; --level) {
+        Inner* inner = static_cast<Inner*>(node);
+        int i = childIndex(inner, prefix, key, last);
+        path.push_back({inner, i});
+        node = inner->children[i];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+//move "path" on to the leaf after the one it leads to now, and return that leaf (nullptr after the last one)
+BPlusTree::Leaf* BPlusTree::nextLeaf() {
+    size_t depth = path.size();
+    while (!path.empty() && path.back().second == path.back().first->count) {
+        path.pop_back();
+    }
+    if (path.empty()) {
+        return nullptr;
+    }
+    ++path.back().second;
+    void* node = path.back().first->children[path.back().second];
+    while (path.size() < depth) {
+        path.push_back({static_cast<Inner*>(node), 0});
+        node = static_cast<Inner*>(node)->children[0];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+/**
+ * Traverse the tree in order
+ */
+void BPlusTree::InOrder() {
+    if (root == nullptr) {
+        return;
+    }
+    //down the left edge to the first leaf, then along the leaves
+    void* node = root;
+    for (int level = levels; level > 1; --level) {
+        node = static_cast<Inner*>(node)->children[0];
+    }
+    for (const Leaf* leaf = static_cast<Leaf*>(node); leaf != nullptr; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; ++i) {
+            const Bid& bid = leaf->bids[i];
+            //output bidID, title, amount, fund
+            cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | " << bid.fund << endl;
+        }
+    }
+}
+
+/**
+ * Search for a bid
+ */
+Bid BPlusTree::Search(const string& bidId) {
+    const Bid* found = Find(bidId);
+    if (found != nullptr) {
+        return *found;
+    }
+    Bid emptyBid;
+    return emptyBid;
+}
+
+/**
+ * Search for a bid without copying it
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or nullptr if it isn't in the tree. Only good until the tree changes.
+ */
+const Bid* BPlusTree::Find(string_view bidId) const {
+    if (root == nullptr) {
+        return nullptr;
+    }
+    uint64_t prefix = prefixOf(bidId);
+    const void* node = root;
+    for (int level = levels; level > 1; --level) {
+        const Inner* inner = static_cast<const Inner*>(node);
+        node = inner->children[childIndex(inner, prefix, bidId, false)];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(node);
+    int i = leafIndex(leaf, prefix, bidId, false);
+    if (i == leaf->count) {
+        //everything in this leaf is smaller, so if the bid is anywhere it's first in the next one
+        leaf = leaf->next;
+        i = 0;
+    }
+    if (leaf != nullptr && leaf->prefixes[i] == prefix && leaf->bids[i].bidId == bidId) {
+        return &leaf->bids[i];
+    }
+    return nullptr;
+}
+
+//put a bid in at position i of a leaf that has room, sliding the rest over
+void BPlusTree::insertAt(Leaf* leaf, int i, uint64_t prefix, Bid bid) {
+    copy_backward(leaf->prefixes + i, leaf->prefixes + leaf->count, leaf->prefixes + leaf->count + 1);
+    move_backward(leaf->bids + i, leaf->bids + leaf->count, leaf->bids + leaf->count + 1);
+    leaf->prefixes[i] = prefix;
+    leaf->bids[i] = std::move(bid);
+    ++leaf->count;
+}
+
+//put a key in at position i of an inner node that has room, with "right" as the child after it
+void BPlusTree::insertKey(Inner* node, int i, uint64_t prefix, string key, void* right) {
+    copy_backward(node->prefixes + i, node->prefixes + node->count, node->prefixes + node->count + 1);
+    move_backward(node->keys + i, node->keys + node->count, node->keys + node->count + 1);
+    copy_backward(node->children + i + 1, node->children + node->count + 1, node->children + node->count + 2);
+    node->prefixes[i] = prefix;
+    node->keys[i] = std::move(key);
+    node->children[i + 1] = right;
+    ++node->count;
+}
+
+//take key i, and the child after it, out of an inner node
+void BPlusTree::removeKey(Inner* node, int i) {
+    copy(node->prefixes + i + 1, node->prefixes + node->count, node->prefixes + i);
+    move(node->keys + i + 1, node->keys + node->count, node->keys + i);
+    copy(node->children + i + 2, node->children + node->count + 1, node->children + i + 1);
+    --node->count;
+}
+
+/**
+ * Insert a bid
+ *
+ * A bid with an id that's already in the tree goes in after the copies already there.
+ */
+void BPlusTree::Insert(const Bid& bid) {
+    if (root == nullptr) {
+        root = new Leaf();
+        levels = 1;
+    }
+
+    uint64_t prefix = prefixOf(bid.bidId);
+    Leaf* leaf = findLeaf(prefix, bid.bidId, true);
+    int i = leafIndex(leaf, prefix, bid.bidId, true);
+
+    ++size;
+    if (leaf->count < LEAF_SIZE) {
+        insertAt(leaf, i, prefix, bid);
+    } else {
+        splitLeaf(leaf, i, prefix, bid);
+    }
+}
+
+//helper for Insert(): the leaf is full, so its top half moves to a new leaf and the new
+//leaf's first key goes up into the parent. If that fills the parent up it splits too, and so on.
+void BPlusTree::splitLeaf(Leaf* leaf, int i, uint64_t prefix, const Bid& bid) {
+    Leaf* sibling = new Leaf();
+    copy(leaf->prefixes + MIN_LEAF, leaf->prefixes + LEAF_SIZE, sibling->prefixes);
+    move(leaf->bids + MIN_LEAF, leaf->bids + LEAF_SIZE, sibling->bids);
+    sibling->count = LEAF_SIZE - MIN_LEAF;
+    leaf->count = MIN_LEAF;
+    sibling->next = leaf->next;
+    leaf->next = sibling;
+    if (i <= MIN_LEAF) {
+        insertAt(leaf, i, prefix, bid);
+    } else {
+        insertAt(sibling, i - MIN_LEAF, prefix, bid);
+    }
+
+    //back up the path, each time with a key and the new node that goes right of it
+    uint64_t upPrefix = sibling->prefixes[0];
+    string upKey = sibling->bids[0].bidId;
+    void* right = sibling;
+    while (!path.empty()) {
+        Inner* node = path.back().first;
+        int at = path.back().second;
+        path.pop_back();
+        if (node->count < INNER_SIZE) {
+            insertKey(node, at, upPrefix, std::move(upKey), right);
+            return;
+        }
+
+        //full as well: keys past the middle go to a new node, and the middle key goes up.
+        //If the new key would be the middle one, it just goes straight up instead.
+        Inner* split = new Inner();
+        int mid = INNER_SIZE / 2;
+        if (at == mid) {
+            copy(node->prefixes + mid, node->prefixes + INNER_SIZE, split->prefixes);
+            move(node->keys + mid, node->keys + INNER_SIZE, split->keys);
+            copy(node->children + mid + 1, node->children + INNER_SIZE + 1, split->children + 1);
+            split->children[0] = right;
+            split->count = INNER_SIZE - mid;
+            node->count = mid;
+        } else {
+            uint64_t middlePrefix = node->prefixes[mid];
+            string middleKey = std::move(node->keys[mid]);
+            copy(node->prefixes + mid + 1, node->prefixes + INNER_SIZE, split->prefixes);
+            move(node->keys + mid + 1, node->keys + INNER_SIZE, split->keys);
+            copy(node->children + mid + 1, node->children + INNER_SIZE + 1, split->children);
+            split->count = INNER_SIZE - mid - 1;
+            node->count = mid;
+            if (at < mid) {
+                insertKey(node, at, upPrefix, std::move(upKey), right);
+            } else {
+                insertKey(split, at - mid - 1, upPrefix, std::move(upKey), right);
+            }
+            upPrefix = middlePrefix;
+            upKey = std::move(middleKey);
+        }
+        right = split;
+    }
+
+    //the root split, so there's a new root above it and the tree is one level taller
+    Inner* top = new Inner();
+    top->prefixes[0] = upPrefix;
+    top->keys[0] = std::move(upKey);
+    top->children[0] = root;
+    top->children[1] = right;
+    top->count = 1;
+    root = top;
+    ++levels;
+}
+
+/**
+ * Remove a bid
+ */
+void BPlusTree::Remove(const string& bidId) {
+    Erase(bidId);
+}
+
+/**
+ * Remove a bid by id (the first copy, if the id is in there more than once)
+ *
+ * @param bidId The bid id to remove
+ * @return false if there was no such bid
+ */
+bool BPlusTree::Erase(string_view bidId) {
+    if (root == nullptr) {
+        return false;
+    }
+    uint64_t prefix = prefixOf(bidId);
+    Leaf* leaf = findLeaf(prefix, bidId, false);
+    int i = leafIndex(leaf, prefix, bidId, false);
+    if (i == leaf->count) {
+        //same as Find(), it can only be first in the next leaf. "path" moves along with it for fixUnderflow()
+        leaf = nextLeaf();
+        i = 0;
+    }
+    if (leaf == nullptr || leaf->prefixes[i] != prefix || leaf->bids[i].bidId != bidId) {
+        return false;
+    }
+
+    copy(leaf->prefixes + i + 1, leaf->prefixes + leaf->count, leaf->prefixes + i);
+    move(leaf->bids + i + 1, leaf->bids + leaf->count, leaf->bids + i);
+    --leaf->count;
+    --size;
+
+    //the keys in the inner nodes can stay as they are even if one was this bid's id,
+    //taking a bid out of a leaf can't put anything on the wrong side of one
+    if (levels == 1) {
+        if (leaf->count == 0) {
+            delete leaf;
+            root = nullptr;
+            levels = 0;
+        }
+    } else if (leaf->count < MIN_LEAF) {
+        fixUnderflow(leaf);
+    }
+    return true;
+}
+
+//helper for Erase(): the leaf is less than half full, so it takes a bid from a neighbour that
+//can spare one, or else gets merged with a neighbour. A merge takes a key out of the parent,
+//which can leave that one less than half full, and so on up.
+void BPlusTree::fixUnderflow(Leaf* leaf) {
+    Inner* parent = path.back().first;
+    int at = path.back().second;
+    path.pop_back();
+    Leaf* left = at > 0 ? static_cast<Leaf*>(parent->children[at - 1]) : nullptr;
+    Leaf* right = at < parent->count ? static_cast<Leaf*>(parent->children[at + 1]) : nullptr;
+
+    if (left != nullptr && left->count > MIN_LEAF) {
+        //left neighbour's last bid moves over, and becomes the key between them
+        --left->count;
+        insertAt(leaf, 0, left->prefixes[left->count], std::move(left->bids[left->count]));
+        parent->prefixes[at - 1] = leaf->prefixes[0];
+        parent->keys[at - 1] = leaf->bids[0].bidId;
+        return;
+    }
+    if (right != nullptr && right->count > MIN_LEAF) {
+        //right neighbour's first bid moves over, and its second one becomes the key between them
+        leaf->prefixes[leaf->count] = right->prefixes[0];
+        leaf->bids[leaf->count] = std::move(right->bids[0]);
+        ++leaf->count;
+        copy(right->prefixes + 1, right->prefixes + right->count, right->prefixes);
+        move(right->bids + 1, right->bids + right->count, right->bids);
+        --right->count;
+        parent->prefixes[at] = right->prefixes[0];
+        parent->keys[at] = right->bids[0].bidId;
+        return;
+    }
+
+    //neither can spare one, so two leaves become one: this one into the left neighbour, or the right one into this
+    if (left == nullptr) {
+        left = leaf;
+        leaf = right;
+        ++at;
+    }
+    copy(leaf->prefixes, leaf->prefixes + leaf->count, left->prefixes + left->count);
+    move(leaf->bids, leaf->bids + leaf->count, left->bids + left->count);
+    left->count += leaf->count;
+    left->next = leaf->next;
+    delete leaf;
+    removeKey(parent, at - 1);
+
+    //now the same for the inner nodes on the way up
+    Inner* node = parent;
+    while (!path.empty() && node->count < MIN_INNER) {
+        parent = path.back().first;
+        at = path.back().second;
+        path.pop_back();
+        Inner* leftNode = at > 0 ? static_cast<Inner*>(parent->children[at - 1]) : nullptr;
+        Inner* rightNode = at < parent->count ? static_cast<Inner*>(parent->children[at + 1]) : nullptr;
+
+        if (leftNode != nullptr && leftNode->count > MIN_INNER) {
+            //the key between them comes down in front, the left neighbour's last child moves over,
+            //and its last key goes up in between
+            insertKey(node, 0, parent->prefixes[at - 1], std::move(parent->keys[at - 1]), node->children[0]);
+            node->children[0] = leftNode->children[leftNode->count];
+            --leftNode->count;
+            parent->prefixes[at - 1] = leftNode->prefixes[leftNode->count];
+            parent->keys[at - 1] = std::move(leftNode->keys[leftNode->count]);
+            return;
+        }
+        if (rightNode != nullptr && rightNode->count > MIN_INNER) {
+            //same thing the other way around
+            insertKey(node, node->count, parent->prefixes[at], std::move(parent->keys[at]), rightNode->children[0]);
+            parent->prefixes[at] = rightNode->prefixes[0];
+            parent->keys[at] = std::move(rightNode->keys[0]);
+            copy(rightNode->children + 1, rightNode->children + rightNode->count + 1, rightNode->children);
+            copy(rightNode->prefixes + 1, rightNode->prefixes + rightNode->count, rightNode->prefixes);
+            move(rightNode->keys + 1, rightNode->keys + rightNode->count, rightNode->keys);
+            --rightNode->count;
+            return;
+        }
+
+        //merge: the key between the two comes down, with the right node's keys and children after it
+        if (leftNode == nullptr) {
+            leftNode = node;
+            node = rightNode;
+            ++at;
+        }
+        leftNode->prefixes[leftNode->count] = parent->prefixes[at - 1];
+        leftNode->keys[leftNode->count] = std::move(parent->keys[at - 1]);
+        copy(node->prefixes, node->prefixes + node->count, leftNode->prefixes + leftNode->count + 1);
+        move(node->keys, node->keys + node->count, leftNode->keys + leftNode->count + 1);
+        copy(node->children, node->children + node->count + 1, leftNode->children + leftNode->count + 1);
+        leftNode->count += node->count + 1;
+        delete node;
+        removeKey(parent, at - 1);
+        node = parent;
+    }
+
+    //a root with no keys left has just the one child, which becomes the root
+    if (node == root && node->count == 0) {
+        root = node->children[0];
+        delete node;
+        --levels;
     }
 }
 
@@ -369,51 +1170,187 @@ void displayBid(const Bid& bid) {
  * @param csvPath the path to the CSV file to load
  * @return a container holding all the bids read
  */
-void loadBids(const string& csvPath, BinarySearchTree* bst) {
+void loadBids(const string& csvPath, BidTree* bst) {
     cout << "Loading CSV file " << csvPath << endl;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
-
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
-    }
-    cout << "" << endl;
-
     try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
-
+        // initialize the CSV Parser using the given path
+        // only id, title, fund and winning bid get loaded (columns 1, 0, 8 and 4). The file is streamed
+        // and each bid gets inserted as soon as its row is read, while the columns are kept for a binary
+        // snapshot next to the CSV, so loading the same file again skips the parsing
+        auto insert = [bst](const csv::Table& file, size_t i) {
             // Create a data structure and add to the collection of bids
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+            bid.bidId = file.str(0, i);
+            bid.title = file.str(1, i);
+            bid.fund = file.str(2, i);
+            bid.amount = file.doubles(3)[i];
 
             //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
 
             // push this bid to the end
             bst->Insert(bid);
+        };
+        csv::Table file = csv::Table::open(csvPath, BID_COLUMNS, ',', insert);
+        if (file.fromSnapshot()) {
+            cout << "Read from snapshot " << csvPath << ".snap" << endl;
+        }
+
+        // read and display header row - optional
+        for (unsigned int c = 0; c < file.columnCount(); c++) {
+            cout << file.name(c) << " | ";
+        }
+        cout << "" << endl;
+    } catch (csv::Error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/**
+ * Read all the bids in a CSV file, for the benchmarks
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param bids gets the bids
+ * @return false if the file couldn't be read or had no bids
+ */
+bool readBids(const string& csvPath, vector<Bid>& bids) {
+    try {
+        csv::Table file = csv::Table::open(csvPath, BID_COLUMNS);
+        const double* amounts = file.doubles(3);
+        bids.resize(file.rowCount());
+        for (size_t i = 0; i < file.rowCount(); i++) {
+            bids[i].bidId = file.str(0, i);
+            bids[i].title = file.str(1, i);
+            bids[i].fund = file.str(2, i);
+            bids[i].amount = amounts[i];
         }
     } catch (csv::Error &e) {
         std::cerr << e.what() << std::endl;
+        return false;
+    }
+    if (bids.empty()) {
+        cout << "No bids in " << csvPath << endl;
+        return false;
     }
+    return true;
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Build the tree from the bids sorted by id, reverse sorted and shuffled, with
+ * and without balancing, and report the height and how long a lookup takes
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkBalancing(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+
+    // every id gets looked up, in random order
+    mt19937 random(42);
+    vector<string> lookups;
+    for (const Bid& bid : bids) {
+        lookups.push_back(bid.bidId);
+    }
+    shuffle(lookups.begin(), lookups.end(), random);
+
+    const char* orders[] = {"sorted", "reverse sorted", "shuffled"};
+    for (int order = 0; order < 3; ++order) {
+        if (order == 0) {
+            sort(bids.begin(), bids.end(), [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; });
+        } else if (order == 1) {
+            reverse(bids.begin(), bids.end());
+        } else {
+            shuffle(bids.begin(), bids.end(), random);
+        }
+
+        for (bool balance : {false, true}) {
+            BinarySearchTree tree(balance);
+            clock_t ticks = clock();
+            for (const Bid& bid : bids) {
+                tree.Insert(bid);
+            }
+            double insertSeconds = (clock() - ticks) * 1.0 / CLOCKS_PER_SEC;
+
+            ticks = clock();
+            size_t found = 0;
+            for (const string& id : lookups) {
+                found += tree.Find(id) != nullptr;
+            }
+            double lookupSeconds = (clock() - ticks) * 1.0 / CLOCKS_PER_SEC;
+
+            cout << orders[order] << (balance ? ", AVL: " : ", plain: ") << "height " << tree.Height()
+                 << ", insert " << insertSeconds << " s, lookup " << lookupSeconds * 1e9 / lookups.size() << " ns";
+            if (found != lookups.size()) {
+                cout << "  (only " << found << " found)";
+            }
+            cout << endl;
+        }
+    }
+}
+
+/**
+ * Build the AVL tree and the B+ tree from the same bids, and time inserting
+ * them (shuffled) and then looking every one of them up (shuffled again)
  *
- * @param ch The character to strip out
+ * The CSV's bids all fit in the cache either way, so it runs again with a
+ * million made-up ids, where the tree no longer does and every level that
+ * misses the cache counts.
+ *
+ * @param csvPath the path to the CSV file to load
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str()); //will not report conversion errors, maybe fix later if time
+void benchmarkBPlusTree(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+    mt19937 random(42);
+
+    for (int round = 0; round < 2; ++round) {
+        if (round == 1) {
+            // just ids, no titles, or the trees would mostly be measuring string copies
+            bids.assign(1 << 20, Bid());
+            for (size_t i = 0; i < bids.size(); ++i) {
+                bids[i].bidId = to_string(1000000 + i);
+            }
+        }
+        shuffle(bids.begin(), bids.end(), random);
+        vector<string> lookups;
+        for (const Bid& bid : bids) {
+            lookups.push_back(bid.bidId);
+        }
+        shuffle(lookups.begin(), lookups.end(), random);
+        cout << bids.size() << (round == 0 ? " bids from " + csvPath : " made-up bids") << ":" << endl;
+
+        for (int kind = 0; kind < 2; ++kind) {
+            unique_ptr<BidTree> tree;
+            if (kind == 0) {
+                tree.reset(new BinarySearchTree());
+            } else {
+                tree.reset(new BPlusTree());
+            }
+            clock_t ticks = clock();
+            for (const Bid& bid : bids) {
+                tree->Insert(bid);
+            }
+            double insertSeconds = (clock() - ticks) * 1.0 / CLOCKS_PER_SEC;
+
+            ticks = clock();
+            size_t found = 0;
+            for (const string& id : lookups) {
+                found += tree->Find(id) != nullptr;
+            }
+            double lookupSeconds = (clock() - ticks) * 1.0 / CLOCKS_PER_SEC;
+
+            cout << (kind == 0 ? "  AVL: " : "  B+:  ") << "height " << tree->Height()
+                 << ", insert " << insertSeconds << " s, lookup " << lookupSeconds * 1e9 / lookups.size() << " ns";
+            if (found != lookups.size()) {
+                cout << "  (only " << found << " found)";
+            }
+            cout << endl;
+        }
+    }
 }
 
 /**
@@ -422,8 +1359,15 @@ double strToDouble(string str, char ch) {
 int main(int argc, char* argv[]) {
 
     // process command line arguments
-    string csvPath, bidKey;
+    // an optional third argument "bloom" puts a Bloom filter in front of the tree,
+    // "bplus" uses the B+ tree instead of the binary search tree
+    string csvPath, bidKey, option;
     switch (argc) {
+        case 4:
+            csvPath = argv[1];
+            bidKey = argv[2];
+            option = argv[3];
+            break;
         case 2:
             csvPath = argv[1];
             //bidKey = "98109"; //you already know... bid 98109 doesn't exist in the sample data!
@@ -442,8 +1386,18 @@ int main(int argc, char* argv[]) {
     clock_t ticks;
 
     // Define a binary search tree to hold all bids
-    BinarySearchTree* bst;
-    bst = new BinarySearchTree();
+    BidTree* bst;
+    if (option == "bplus") {
+        bst = new BPlusTree();
+        cout << "Using a B+ tree" << endl;
+    } else {
+        BinarySearchTree* tree = new BinarySearchTree();
+        if (option == "bloom") {
+            tree->enableFilter();
+            cout << "Using a Bloom filter in front of the tree" << endl;
+        }
+        bst = tree;
+    }
     Bid bid;
 
     int choice = 0;
@@ -453,6 +1407,8 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Benchmark Balancing" << endl;
+        cout << "  6. Benchmark B+ Tree" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -468,6 +1424,11 @@ int main(int argc, char* argv[]) {
                 loadBids(csvPath, bst);
 
                 //cout << bst->Size() << " bids read" << endl;
+                if (bst->getFilter() != nullptr) {
+                    cout << "Bloom filter: " << bst->getFilter()->size() << " bids, "
+                         << bst->getFilter()->bytes() << " bytes, estimated false positive rate "
+                         << bst->getFilter()->falsePositiveRate() * 100.0 << "%" << endl;
+                }
 
                 // Calculate elapsed time and display result
                 ticks = clock() - ticks; // current clock ticks minus starting clock ticks
@@ -500,9 +1461,19 @@ int main(int argc, char* argv[]) {
             case 4:
                 bst->Remove(bidKey);
                 break;
+
+            case 5:
+                benchmarkBalancing(csvPath);
+                break;
+
+            case 6:
+                benchmarkBPlusTree(csvPath);
+                break;
         }
     }
 
+    delete bst;
+
     cout << "Good bye." << endl;
 
     return 0;
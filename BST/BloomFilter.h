@@ -0,0 +1,146 @@
+//============================================================================
+// Name        : BloomFilter.h
+// Description : Blocked Bloom filter to answer "definitely not there" lookups
+//               without walking a hash chain or a tree path.
+//               Hash2/ and BST/ each have a copy, keep them the same.
+//============================================================================
+
+#ifndef BLOOMFILTER_H_
+#define BLOOMFILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+ * Blocked ("split block") Bloom filter
+ *
+ * The bits are split into 512 bit blocks, one 64 byte cache line each. A key
+ * picks one block with its hash and sets one bit in each of the block's 8
+ * words, so adding or checking a key touches exactly one cache line, where a
+ * plain Bloom filter touches k random ones.
+ *
+ * Nothing can be taken out of a Bloom filter: after removes it still says
+ * "maybe" for the removed keys until it gets rebuilt from what's left.
+ */
+class BloomFilter {
+
+private:
+    struct alignas(64) Block {
+        uint64_t words[8];
+    };
+
+    std::vector<Block> blocks;
+    double bitsPerKey;
+    size_t capacity = 0; // keys it was sized for
+    size_t added = 0;    // keys added since the last reset
+
+    // the hash given to add/mayContain may be weak (the modulo hash is just the id),
+    // so it gets mixed again (murmur3's finalizer) before picking bits
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t blockOf(uint64_t h) const {
+        return ((h >> 32) * blocks.size()) >> 32;
+    }
+
+    // bit to set in word i, picked by a different odd multiplier per word
+    static uint64_t bit(uint64_t h, unsigned int i) {
+        static const uint32_t salts[8] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                          0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+        return uint64_t(1) << ((static_cast<uint32_t>(h) * salts[i]) >> 26);
+    }
+
+public:
+    /**
+     * @param expected how many keys to size the filter for
+     * @param bits memory per key, 10 bits gives about a 1% false positive rate
+     */
+    explicit BloomFilter(size_t expected = 0, double bits = 10) : bitsPerKey(bits) {
+        reset(expected);
+    }
+
+    /**
+     * Empty the filter and size it for a new number of keys
+     *
+     * @param expected how many keys are going to be added
+     */
+    void reset(size_t expected) {
+        capacity = expected < 64 ? 64 : expected;
+        size_t count = static_cast<size_t>(capacity * bitsPerKey / 512) + 1;
+        blocks.assign(count, Block{});
+        added = 0;
+    }
+
+    /**
+     * Add a key by its hash
+     */
+    void addHash(uint64_t h) {
+        h = mix(h);
+        Block& block = blocks[blockOf(h)];
+        for (unsigned int i = 0; i < 8; ++i) {
+            block.words[i] |= bit(h, i);
+        }
+        ++added;
+    }
+
+    /**
+     * false means the key was never added, true means it probably was
+     */
+    bool mayContainHash(uint64_t h) const {
+        h = mix(h);
+        const Block& block = blocks[blockOf(h)];
+        for (unsigned int i = 0; i < 8; ++i) {
+            if ((block.words[i] & bit(h, i)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Same as addHash/mayContainHash, for containers that don't hash their keys themselves
+     */
+    void add(std::string_view key) { addHash(std::hash<std::string_view>()(key)); }
+    bool mayContain(std::string_view key) const { return mayContainHash(std::hash<std::string_view>()(key)); }
+
+    /**
+     * Estimated chance that mayContain says true for a key that was never added
+     *
+     * Worked out from how full the blocks actually are: a missing key lands in
+     * a random block and gets a false positive if all 8 of its bits happen to
+     * be set, and each word's fill says how likely that is for its bit.
+     */
+    double falsePositiveRate() const {
+        double sum = 0;
+        for (const Block& block : blocks) {
+            double p = 1;
+            for (unsigned int i = 0; i < 8 && p > 0; ++i) {
+                int set = 0;
+                for (uint64_t w = block.words[i]; w != 0; w &= w - 1) {
+                    ++set;
+                }
+                p *= set / 64.0;
+            }
+            sum += p;
+        }
+        return blocks.empty() ? 0 : sum / blocks.size();
+    }
+
+    size_t size() const { return added; }
+    size_t sizedFor() const { return capacity; }
+    size_t bytes() const { return blocks.size() * sizeof(Block); }
+
+    // once more keys went in than it was sized for, the false positive rate climbs fast
+    bool overfull() const { return added > capacity; }
+};
+
+#endif //BLOOMFILTER_H_
@@ -6,9 +6,52 @@
 # include <vector>
 # include <list>
 # include <sstream>
+# include <string_view>
+# include <cstddef>
+# include <fstream>
+# include <iterator>
+# include <memory>
+# include <unordered_map>
+# include <charconv>
+# include <system_error>
+# include <type_traits>
+# include <initializer_list>
+# include <cstdint>
+# include <functional>
 
 namespace csv
 {
+    /*
+    ** Allocation-free field conversion. These never throw : the result is only
+    ** written when std::errc() comes back, otherwise the errc says what went wrong.
+    */
+
+    // drops surrounding spaces and one pair of surrounding quotes
+    std::string_view trimField(std::string_view);
+
+    template<typename T>
+    std::errc toNumber(std::string_view text, T &out)
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                      "toNumber only converts integer and floating point types");
+
+        text = trimField(text);
+        if (!text.empty() && text.front() == '+')
+            text.remove_prefix(1);
+
+        T value;
+        std::from_chars_result res = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (res.ec != std::errc())
+            return res.ec;
+        if (res.ptr != text.data() + text.size() || text.empty())
+            return std::errc::invalid_argument;
+        out = value;
+        return std::errc();
+    }
+
+    // money strings like "$3,000 ", $78.51 or -$5.00
+    std::errc toMoney(std::string_view text, double &out);
+
     class Error : public std::runtime_error
     {
 
@@ -19,32 +62,106 @@ namespace csv
         }
     };
 
+    /*
+    ** Columns to keep while parsing, by position or by header name. The other
+    ** fields are still checked for count but never copied. Empty keeps everything.
+    **
+    **     csv::Stream file(path, csv::Columns{0, 1, 4, 8});
+    */
+    class Columns
+    {
+
+    public:
+        Columns() = default;
+        Columns(std::initializer_list<unsigned int> positions);
+        Columns(std::initializer_list<std::string> names);
+
+    public:
+        Columns &add(unsigned int pos);
+        Columns &add(const std::string &name);
+        bool empty() const;
+
+    private:
+        friend class Schema;
+        std::vector<unsigned int> _positions;
+        std::vector<std::string> _names;
+    };
+
+    /*
+    ** Column names of a file. A parser builds one and every row points to it,
+    ** names are looked up through a hash map instead of scanning the header.
+    ** When only some columns are loaded, slot() maps a file column to its
+    ** place in the row's values.
+    */
+    class Schema
+    {
+
+    public:
+        static constexpr unsigned int npos = static_cast<unsigned int>(-1);
+
+        explicit Schema(std::vector<std::string> names, const Columns &columns = Columns());
+        Schema(const Schema &) = delete; // _index points into _names
+        Schema &operator=(const Schema &) = delete;
+
+    public:
+        unsigned int size() const;
+        const std::vector<std::string> &names() const;
+        const std::string &name(unsigned int pos) const;
+        unsigned int find(std::string_view name) const; // npos if there's no such column
+        unsigned int column(std::string_view name) const; // throws if there's no such column
+
+    public:
+        unsigned int width() const; // number of columns actually loaded
+        bool projected() const;
+        bool keeps(unsigned int pos) const;
+
+        unsigned int slot(unsigned int pos) const // npos if the column isn't loaded
+        {
+            return pos < _slots.size() ? _slots[pos] : npos;
+        }
+
+    private:
+        std::vector<std::string> _names;
+        std::unordered_map<std::string_view, unsigned int> _index;
+        std::vector<unsigned int> _slots;
+        unsigned int _width;
+    };
+
     class Row
     {
     public:
-        explicit Row(const std::vector<std::string> &);
+        explicit Row(std::shared_ptr<const Schema>);
         ~Row();
 
     public:
         unsigned int size() const;
-        void push(const std::string &);
+        void push(std::string);
         bool set(const std::string &, const std::string &);
 
     private:
-        const std::vector<std::string> _header;
+        friend class Parser;
+        std::shared_ptr<const Schema> _schema;
         std::vector<std::string> _values;
+        bool _changed; // set() was called since the last Parser::sync()
 
     public:
 
+        // numbers go through toNumber (T() if the value isn't a number), anything else through a stringstream
         template<typename T>
         T getValue(unsigned int pos) const
         {
-            if (pos < _values.size())
+            unsigned int slot = _schema->slot(pos);
+            if (slot < _values.size())
             {
-                T res;
-                std::stringstream ss;
-                ss << _values[pos];
-                ss >> res;
+                T res{};
+                if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value)
+                    toNumber(_values[slot], res);
+                else
+                {
+                    std::stringstream ss;
+                    ss << _values[slot];
+                    ss >> res;
+                }
                 return res;
             }
             throw Error("can't return this value (doesn't exist)");
@@ -60,11 +177,19 @@ namespace csv
         ePURE = 1
     };
 
+    enum SyncMode {
+        eSYNC_ALL = 0,    // always rewrite the whole file (into a temp file that replaces it, crash-safe)
+        eSYNC_CHANGED = 1 // skip the write when nothing changed, append when rows were only added at the end
+                          // (appending writes to the file in place: a crash can cut the last row off)
+    };
+
     class Parser
     {
 
     public:
-        explicit Parser(const std::string &, const DataType &type = eFILE, char sep = ','); //maybe should be marked "explicit"
+        // threads = 0 uses one thread per core, as long as each gets at least 1 MiB of the file
+        explicit Parser(const std::string &, const DataType &type = eFILE, char sep = ',', unsigned int threads = 0); //maybe should be marked "explicit"
+        Parser(const std::string &, const Columns &columns, const DataType &type = eFILE, char sep = ',', unsigned int threads = 0);
         ~Parser();
 
     public:
@@ -73,28 +198,306 @@ namespace csv
         unsigned int columnCount() const;
         std::vector<std::string> getHeader() const;
         const std::string getHeaderElement(unsigned int pos) const;
+        const Schema &getSchema() const;
         const std::string &getFileName() const;
 
     public:
         bool deleteRow(unsigned int row);
         bool addRow(unsigned int pos, const std::vector<std::string> &);
-        void sync() const;
+        void sync(SyncMode mode = eSYNC_ALL) const;
 
     protected:
-        void parseHeader();
-        void parseContent();
+        void parse(std::string_view text);
+        void parseHeader(std::string_view line);
+        void parseContent(std::string_view text);
+        void parseChunk(std::string_view chunk, std::vector<Row *> &rows) const;
 
     private:
         std::string _file;
         const DataType _type;
         const char _sep;
-        std::vector<std::string> _originalFile;
-        std::vector<std::string> _header;
+        const unsigned int _threads;
+        const Columns _columns;
+        std::shared_ptr<const Schema> _schema;
         std::vector<Row *> _content;
+        mutable std::size_t _synced;  // leading rows that are in the file as they are now
+        mutable bool _reordered;      // a row was deleted or inserted before the end since the last sync
+
+    private:
+        void writeRow(std::string &out, const Row &row) const;
+        void writeAll() const;
+        void appendFrom(std::size_t first) const;
 
     public:
         Row &operator[](unsigned int row) const;
     };
+
+    /*
+    ** Read-only view of a whole file mapped into memory
+    */
+    class MappedFile
+    {
+
+    public:
+        explicit MappedFile(const std::string &);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+    public:
+        const char *data() const;
+        std::size_t size() const;
+        std::string_view view() const;
+
+    private:
+        const char *_data;
+        std::size_t _size;
+        void *_handle; // file mapping handle, only used on Windows
+    };
+
+    // splits one line on sep (outside of quotes) and appends the fields to out
+    void splitLine(std::string_view line, char sep, std::vector<std::string_view> &out);
+
+    // instruction set used by splitLine, the best one the CPU supports is picked at startup
+    enum ScanLevel {
+        eSCALAR = 0,
+        eSSE2 = 1,
+        eAVX2 = 2
+    };
+
+    ScanLevel detectScanLevel();
+    ScanLevel getScanLevel();
+    ScanLevel setScanLevel(ScanLevel level); // capped to detectScanLevel(), returns the level in use
+
+    /*
+    ** Row whose fields are slices of some buffer owned by the parser
+    */
+    class RowView
+    {
+
+    public:
+        RowView(const std::string_view *fields, unsigned int count, const Schema *schema = nullptr);
+
+    public:
+        unsigned int size() const;
+        std::string_view operator[](unsigned int) const;
+        std::string_view operator[](std::string_view valueName) const;
+
+        // non-throwing typed access, errc::result_out_of_range if the column isn't loaded
+        template<typename T>
+        std::errc getValue(unsigned int pos, T &out) const
+        {
+            const std::string_view *value = field(pos);
+            if (value == nullptr)
+                return std::errc::result_out_of_range;
+            return toNumber(*value, out);
+        }
+        std::errc getMoney(unsigned int pos, double &out) const;
+
+    private:
+        const std::string_view *field(unsigned int pos) const
+        {
+            unsigned int slot = _schema != nullptr ? _schema->slot(pos) : pos;
+            return slot < _size ? &_fields[slot] : nullptr;
+        }
+
+    private:
+        const std::string_view *_fields;
+        unsigned int _size;
+        const Schema *_schema;
+    };
+
+    /*
+    ** Zero-copy parser : mmaps the file, rows and fields point into the mapping.
+    ** Views stay valid as long as the MappedParser is alive.
+    */
+    class MappedParser
+    {
+
+    public:
+        explicit MappedParser(const std::string &, char sep = ',');
+        MappedParser(const std::string &, const Columns &columns, char sep = ',');
+
+    public:
+        RowView getRow(unsigned int row) const;
+        unsigned int rowCount() const;
+        unsigned int columnCount() const;
+        std::vector<std::string> getHeader() const;
+        const Schema &getSchema() const;
+        const std::string &getFileName() const;
+
+    private:
+        std::string _file;
+        const char _sep;
+        MappedFile _map;
+        std::shared_ptr<const Schema> _schema;
+        std::vector<std::string_view> _fields; // row after row, getSchema().width() fields each
+
+    public:
+        RowView operator[](unsigned int row) const;
+    };
+
+    /*
+    ** Forward-only reader : the file is read in blocks of bufferSize bytes and
+    ** rows are handed out one at a time, so memory use doesn't grow with the file.
+    ** A row is only valid until the stream moves to the next one.
+    **
+    **     for (const csv::RowView &row : csv::Stream(path)) ...
+    */
+    class Stream
+    {
+
+    public:
+        explicit Stream(const std::string &, char sep = ',', std::size_t bufferSize = 1 << 16);
+        Stream(const std::string &, const Columns &columns, char sep = ',', std::size_t bufferSize = 1 << 16);
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+    public:
+        class iterator
+        {
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = RowView;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const RowView *;
+            using reference = const RowView &;
+
+            explicit iterator(Stream *stream = nullptr);
+
+            reference operator*() const;
+            pointer operator->() const;
+            iterator &operator++();
+            bool operator==(const iterator &) const;
+            bool operator!=(const iterator &) const;
+
+        private:
+            Stream *_stream; // nullptr once the end of the file is reached
+        };
+
+        iterator begin(); // reads the first row, can only be called once
+        iterator end();
+
+    public:
+        bool next();
+        const RowView &row() const;
+        unsigned int rowNumber() const;
+        unsigned int columnCount() const;
+        const std::vector<std::string> &getHeader() const;
+        const Schema &getSchema() const;
+        const std::string &getFileName() const;
+
+    private:
+        bool readLine(std::string_view &);
+        void fill();
+
+    private:
+        std::string _file;
+        const char _sep;
+        std::ifstream _in;
+        std::vector<char> _buffer;
+        std::size_t _pos;  // start of the unread data in _buffer
+        std::size_t _end;  // end of the valid data in _buffer
+        bool _eof;
+        std::shared_ptr<const Schema> _schema;
+        std::vector<std::string_view> _fields;
+        std::vector<std::string_view> _kept; // the loaded columns of _fields
+        RowView _row;
+        unsigned int _rowNumber;
+    };
+
+    enum ColumnType {
+        eSTRING = 0,
+        eINT64 = 1,
+        eDOUBLE = 2,
+        eMONEY = 3 // "$3,000 " style amounts, stored as doubles
+    };
+
+    // one column to load into a Table, by file position or header name
+    struct ColumnSpec
+    {
+        ColumnSpec(unsigned int pos, ColumnType type = eSTRING);
+        ColumnSpec(std::string name, ColumnType type = eSTRING);
+
+        unsigned int pos;
+        std::string name; // used instead of pos when not empty
+        ColumnType type;
+    };
+
+    /*
+    ** Column-oriented storage : every loaded column lives in its own contiguous
+    ** buffer instead of one heap string per field. String columns are a single
+    ** byte blob plus row offsets, number columns are parsed once into arrays,
+    ** so a scan over one column streams through memory.
+    **
+    ** Columns are numbered in the order they were asked for. Fields that don't
+    ** convert are stored as 0 and counted in conversionErrors().
+    **
+    ** A table can be saved as a binary snapshot (native byte order) and loaded
+    ** back with one mapping of the file. A loaded table reads its columns straight
+    ** out of that mapping, nothing is copied. open() does that automatically with
+    ** <file>.snap whenever the snapshot was built from the same header, column
+    ** list, file size and modification time as the CSV.
+    */
+    class Table
+    {
+
+    public:
+        // called for each row once it's in the table, while the rest of the file is still being read
+        typedef std::function<void(const Table &, std::size_t row)> RowHandler;
+
+        Table(const std::string &file, const std::vector<ColumnSpec> &columns, char sep = ',',
+              const RowHandler &each = nullptr);
+
+        static Table open(const std::string &file, const std::vector<ColumnSpec> &columns, char sep = ',',
+                          const RowHandler &each = nullptr);
+        static Table load(const std::string &snapshot); // throws if it isn't a valid snapshot
+        void save(const std::string &snapshot) const;   // written to a temp file, then renamed over
+        bool fromSnapshot() const;
+
+    public:
+        std::size_t rowCount() const;
+        unsigned int columnCount() const;
+        unsigned int column(std::string_view name) const; // throws if the column wasn't loaded
+        const std::string &name(unsigned int col) const;
+        ColumnType type(unsigned int col) const;
+        std::size_t conversionErrors(unsigned int col) const;
+
+    public:
+        std::string_view str(unsigned int col, std::size_t row) const;
+        const double *doubles(unsigned int col) const; // eDOUBLE and eMONEY columns, rowCount() values
+        const std::int64_t *ints(unsigned int col) const;
+
+        // total of a number column for every distinct value of a string column
+        std::unordered_map<std::string_view, double> sumBy(unsigned int keyCol, unsigned int valueCol) const;
+
+    private:
+        // the values themselves live in _storage (the snapshot mapping, or the buffers a parse filled)
+        struct Data
+        {
+            std::string name;
+            ColumnType type;
+            const double *doubles;
+            const std::int64_t *ints;
+            const char *bytes;             // string columns : every value back to back
+            const std::uint64_t *offsets;  // string columns : rowCount() + 1 offsets into bytes
+            std::uint64_t errors;
+        };
+        struct Buffers;
+
+        Table();
+        const Data &data(unsigned int col) const;
+        static std::uint64_t checksum(const std::string &file, const Schema &schema,
+                                      const std::vector<ColumnSpec> &columns);
+
+    private:
+        std::vector<Data> _columns;
+        std::shared_ptr<const void> _storage; // shared, so copies of a table stay valid
+        std::size_t _rows;
+        std::uint64_t _checksum; // header, column list, size and mtime of the CSV it was built from
+        bool _snapshot;
+    };
 }
 
 #endif /*!CSVPARSER_H_*/
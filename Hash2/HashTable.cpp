@@ -7,12 +7,25 @@
 //============================================================================
 
 #include <algorithm>
+#include <bit>
 #include <climits>
 #include <iostream>
 #include <string> // atoi
 #include <ctime>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <span>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
 
 #include "CSVparser.cpp"
+#include "BloomFilter.h"
 
 using namespace std;
 
@@ -22,6 +35,15 @@ using namespace std;
 
 const unsigned int DEFAULT_SIZE = 179;
 
+// the chained table grows once there's more than this many bids per bucket on average
+const double MAX_LOAD_FACTOR = 1.0;
+
+// with incremental rehashing, how many old buckets (that hold bids) each operation moves over
+const unsigned int MIGRATE_BUCKETS = 4;
+
+// what gets loaded from the CSV: id, title, fund and winning bid (columns 1, 0, 8 and 4)
+const vector<csv::ColumnSpec> BID_COLUMNS = {{1}, {0}, {8}, {4, csv::eMONEY}};
+
 
 
 // define a structure to hold bid information
@@ -55,10 +77,189 @@ struct Bid {
 
 
 // forward declarations
-double strToDouble(string str, char ch);
-
 void displayBid(Bid bid);
 
+void benchmarkScanner(const string& csvPath);
+
+void benchmarkHashFunctions(const string& csvPath);
+
+void benchmarkConcurrentReads(const string& csvPath);
+
+void benchmarkBatchLookup(const string& csvPath);
+void benchmarkBloomFilter(const string& csvPath);
+void benchmarkPerfectHash(const string& csvPath);
+
+bool readBids(const string& csvPath, vector<Bid>& bids);
+
+//============================================================================
+// Hash functions
+//============================================================================
+
+/**
+ * The hash functions both tables can be built with
+ */
+enum HashFunction {
+    eMODULO = 0,   // the original: bid id through strtol, then modulo the table size
+    eFNV1A = 1,    // FNV-1a over the characters
+    eWYHASH = 2,   // wyhash-style multiply/fold over 8 bytes at a time
+    eFIBONACCI = 3 // numeric id times 2^64/phi, the high bits pick the bucket
+};
+
+const char* hashFunctionName(HashFunction function) {
+    const char* names[] = {"modulo", "FNV-1a", "wyhash", "Fibonacci"};
+    return names[function];
+}
+
+/**
+ * 64x64 bit multiply, folded back to 64 bits by xoring the two halves
+ */
+static inline uint64_t mum(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128) a * b;
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t) a, hb = b >> 32, lb = (uint32_t) b;
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t mid = (ll >> 32) + (uint32_t) hl + (uint32_t) lh;
+    uint64_t lo = (mid << 32) | (uint32_t) ll;
+    uint64_t hi = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+/**
+ * Hash a bid id
+ *
+ * @param key the bid id
+ * @param function which hash function to use
+ * @return the 64 bit hash, for eMODULO just the id as a number
+ */
+uint64_t hashKey(string_view key, HashFunction function) {
+    const char* p = key.data();
+    size_t len = key.size();
+
+    switch (function) {
+        case eMODULO: {
+            // exactly what Insert/Remove/Search used to do (strtol needs the terminating 0, hence the copy)
+            string id(key);
+            char* endPtr;
+            long keyLong = strtol(id.c_str(), &endPtr, 10);
+            return static_cast<unsigned int>(static_cast<int>(keyLong));
+        }
+
+        case eFIBONACCI: {
+            uint64_t value = 0;
+            auto result = from_chars(p, p + len, value);
+            if (result.ec == errc() && result.ptr == p + len) {
+                return value * 11400714819323198485ull;
+            }
+            // not a number, nothing to multiply, so fall through to hashing the characters
+        }
+        [[fallthrough]];
+
+        case eFNV1A: {
+            uint64_t h = 14695981039346656037ull;
+            for (size_t i = 0; i < len; ++i) {
+                h ^= (unsigned char) p[i];
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+        case eWYHASH:
+        default: {
+            const uint64_t s0 = 0xa0761d6478bd642full, s1 = 0xe7037ed1a0b428dbull;
+            uint64_t seed = s0;
+            uint64_t a, b;
+            size_t left = len;
+            for (; left > 16; left -= 16, p += 16) {
+                seed = mum(read64(p) ^ s1, read64(p + 8) ^ seed);
+            }
+            if (left >= 8) {
+                a = read64(p);
+                b = read64(p + left - 8);
+            } else if (left >= 4) {
+                a = read32(p);
+                b = read32(p + left - 4);
+            } else if (left > 0) {
+                a = ((uint64_t) (unsigned char) p[0] << 16) | ((uint64_t) (unsigned char) p[left >> 1] << 8)
+                    | (unsigned char) p[left - 1];
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+            return mum(s1 ^ len, mum(a ^ s1, b ^ seed));
+        }
+    }
+}
+
+/**
+ * Ask the CPU to start pulling a cache line in, so it's there by the time it's needed
+ */
+static inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void) p;
+#endif
+}
+
+/**
+ * Turn a hash into an index below n
+ *
+ * wyhash and Fibonacci use the multiply-shift "fastrange" trick on the top
+ * 32 bits: no division, and the high bits are where the Fibonacci multiply
+ * puts the mixing. eMODULO keeps the original modulo, and so does FNV-1a,
+ * because for short keys like ours the last few characters barely reach
+ * its high bits.
+ *
+ * @param h the hash
+ * @param n number of buckets (below 2^32)
+ * @param function the function h came from
+ * @return bucket index
+ */
+static inline size_t reduceHash(uint64_t h, size_t n, HashFunction function) {
+    if (function == eMODULO || function == eFNV1A) {
+        return h % n;
+    }
+    return ((h >> 32) * (uint64_t) n) >> 32;
+}
+
+//============================================================================
+// BidTable interface
+//============================================================================
+
+/**
+ * What main() and loadBids() need from a bid container, so the chained
+ * HashTable and the open addressing OpenHashTable can be swapped for each other
+ *
+ * An id can be in a table more than once (the monthly file has a few repeats),
+ * every table keeps them all: Search finds the first one inserted, and Remove
+ * takes that one out so the next one shows up. Same as the BST and B+ tree.
+ */
+class BidTable {
+public:
+    virtual ~BidTable() {}
+    virtual void Insert(Bid bid) = 0;
+    virtual void PrintAll() = 0;
+    virtual void Remove(string bidId) = 0;
+    virtual Bid Search(string bidId) = 0;
+    virtual void reserve(size_t n) = 0; // make room for n bids up front, so loading doesn't keep growing the table
+    virtual size_t size() const = 0;
+};
+
 //============================================================================
 // HashTable Table class definition
 //============================================================================
@@ -66,49 +267,105 @@ void displayBid(Bid bid);
 /**
  * Define a class containing data members and methods to
  * implement a hash table with chaining.
+ *
+ * The bids themselves sit in one dense array, "entries", in the order they
+ * were inserted (like CPython's compact dict), and the buckets only hold the
+ * index of the first entry of their list. So going over every bid streams
+ * through one array instead of visiting every bucket and chasing nodes all
+ * over the heap, and a bucket is 4 bytes instead of a pointer.
  */
-class HashTable {
+class HashTable : public BidTable {
 
 private:
     // Define structures to hold bids
     struct Node {
         Bid bid;
-        unsigned int key;
-        Node *next;
+        uint64_t hash = 0; // full hash of bid.bidId, so rehashing never hashes a string again
+        unsigned int key = UINT_MAX;
+        int32_t next = NONE; // index of the next entry in the same list, or NONE (REMOVED once it's been removed)
 
-        // default constructor
-        Node() {
-            key = UINT_MAX;
-            next = nullptr;
-        }
-
-        // initialize with a bid
-        Node(Bid aBid) : Node() { //this invokes the default constructor of Node
-            bid = aBid;
-        }
+        Node() {}
 
-        // initialize with a bid and a key
-        Node(Bid aBid, unsigned int aKey) : Node(aBid) {
-            key = aKey;
-        }
+        // initialize with a bid, its hash and its key
+        Node(Bid aBid, uint64_t aHash, unsigned int aKey) : bid(std::move(aBid)), hash(aHash), key(aKey) {}
     };
 
-    vector<Node> nodes; //each node in "nodes" will either be a main node (like a particular bid),
-    // or a linked list if there are collisions... so for example nodes[1] could potentially contain a linked list
-    //and the end of the linked list would be identified by bid.next = nullptr
+    static constexpr int32_t NONE = -1;
+    static constexpr int32_t REMOVED = -2;
 
-    unsigned int tableSize = DEFAULT_SIZE; // note, default size is 179
+    vector<Node> entries; //every bid, in insertion order, removed ones stay as holes until compactEntries()
+    size_t removed = 0;   //how many holes
+
+    vector<int32_t> nodes; //each entry in "nodes" is the head of a linked list of the bids whose key landed there,
+    // or NONE if none did... more than one node in a list means there were collisions
+    //and the end of the linked list would be identified by next = NONE
+    //(this used to be a vector<Node> with the first bid stored right in it, then a vector<Node*> with the
+    // nodes coming out of a slab pool, now the nodes are all in "entries" and the lists link them by index.
+    // "entries" does what the pool was there for: every node in one block, and one free at teardown)
 
-    unsigned int hash(int key); //some integer, which is the result of hashing a key from a node
+    unique_ptr<BloomFilter> filter; // optional, answers most lookups for missing bids without touching nodes
+
+    unsigned int tableSize = DEFAULT_SIZE; // note, default size is 179
+    size_t count = 0; // number of bids stored, to know when the chains are getting too long
+
+    // Incremental rehashing, the way Redis does it: growing just swaps in the new (empty)
+    // array and keeps the old one around, then every Insert/Search/Remove moves a few old
+    // buckets over. While that's going on a bid can be in either array.
+    bool incremental = false;
+    vector<int32_t> oldNodes; // empty unless a migration is running
+    unsigned int oldSize = 0;
+    unsigned int migrated = 0; // old buckets below this one have been moved already
+
+    HashFunction hashFunction = eWYHASH;
+
+    uint64_t hash(string_view bidId) const; //some integer, which is the result of hashing a key from a node
+    unsigned int bucketOf(uint64_t h) const;
+    unsigned int oldBucketOf(uint64_t h) const;
+    static unsigned int nextPrime(unsigned int n);
+    void rehash(unsigned int newSize);
+    void relink(int32_t entry);
+    void migrateBucket(unsigned int i);
+    void migrateStep();
+    void finishMigration();
+    void compactEntries();
+    int32_t findNode(string_view bidId, uint64_t h) const;
+
+    // keys resolved together in SearchBatch, enough to keep a bunch of cache misses in flight
+    static constexpr size_t BATCH_GROUP = 16;
 
 public:
     HashTable(); //the default constructor resizes the vector "nodes" to contain 179 nodes
-    HashTable(unsigned int size);
+    HashTable(unsigned int size, HashFunction function = eWYHASH);
     virtual ~HashTable();
-    void Insert(Bid bid);
-    void PrintAll();
-    void Remove(string bidId);
-    Bid Search(string bidId);
+    void Insert(Bid bid) override;
+    void PrintAll() override;
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void reserve(size_t n) override;
+    size_t size() const override { return count; }
+    unsigned int capacity() const { return tableSize; }
+    void setIncrementalRehash(bool on);
+    void enableFilter(double bitsPerKey = 10);
+    void rebuildFilter();
+    void disableFilter() { filter.reset(); }
+    const BloomFilter* getFilter() const { return filter.get(); }
+    bool rehashing() const { return !oldNodes.empty(); }
+    vector<size_t> chainLengths() const;
+    const Bid* Find(string_view bidId);
+    bool Erase(string_view bidId);
+    size_t SearchBatch(span<const string_view> bidIds, span<const Bid*> found);
+
+    /**
+     * Call visit(bid) for every bid, in the order they were inserted
+     */
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (const Node& entry : entries) {
+            if (entry.next != REMOVED) {
+                visit(entry.bid);
+            }
+        }
+    }
 };
 
 /**
@@ -116,23 +373,22 @@ public:
  */
 HashTable::HashTable() {
     // Initalize node structure by resizing tableSize
-    nodes.resize(tableSize);
+    nodes.resize(tableSize, NONE);
     //tableSize is set to DEFAULT_SIZE which is 179, so we can index from 0 to 178
-    //at this point all we have is a vector containing 179 default Nodes...
-    //each node has a default key and next=nullptr,
-    // and implicitly initializes the 'bid' member with the default constructor of 'Bid'
+    //at this point all we have is a vector containing 179 empty lists (NONE)
 }
 
 /**
  * Constructor for specifying size of the table
  * Use to improve efficiency of hashing algorithm
  * by reducing collisions without wasting memory.
+ * Also picks the hash function, it can't change once bids are in.
  */
-HashTable::HashTable(unsigned int size) {
+HashTable::HashTable(unsigned int size, HashFunction function) : hashFunction(function) {
     // invoke local tableSize to size with this->
     // resize nodes size
     this->tableSize = size;
-    nodes.resize(this->tableSize);
+    nodes.resize(this->tableSize, NONE);
     //can't I just say..... nodes.resize(size)?
     //does it have to be this->nodes...???
 }
@@ -143,34 +399,217 @@ HashTable::HashTable(unsigned int size) {
  */
 HashTable::~HashTable() {
     // FIXME (2): Implement logic to free storage when class is destroyed
-    //We have to iterate through each node in the vector "nodes"
-    unsigned int i;
-    for (i = 0; i < tableSize; ++i) {
-        // Start by pointing to the "next" member of the first node, accessed by nodes[i].next
-        Node* current = nodes[i].next;
-        // Each node could potentially hold a linked list as the result of collisions
-        while (current != nullptr) {
-            Node* temp = current; //create a temp reference to the i node
-            current = current->next; //move "current" to next node in the list
-            delete temp; // Delete the temp reference... rinse and repeat until all linked nodes deleted
-        } //by the end of this, we will still have a vector filled with nodes, but there will not be any linked lists
-    }
+    //This used to walk every linked list and delete the nodes one at a time.
+    //Now all the nodes live in "entries", and the vector frees them all at once.
 }
 
 /**
- * Calculate the hash value of a given key.
- * Note that key is specifically defined as
- * unsigned int to prevent undefined results
- * of a negative list index.
+ * Calculate the hash value of a given key, with whichever
+ * hash function the table was built with (see hashKey).
  *
- * @param key The key to hash
+ * @param bidId The key to hash
  * @return The calculated hash
  */
-unsigned int HashTable::hash(int key) {
+uint64_t HashTable::hash(string_view bidId) const {
     // FIXME (3): Implement logic to calculate a hash value
     //several options... direct hash, double hashing, mid-square hash...
-    //let's keep it simple with a simple modulo hash
-    return key % tableSize;
+    //it started out as a simple modulo hash of the id as a number, which is still there as eMODULO,
+    //but every non-numeric id ended up in bucket 0 and sequential ids lined up, so now the characters get hashed
+    return hashKey(bidId, hashFunction);
+}
+
+/**
+ * Bucket a hash lands in
+ *
+ * @param h the hash of a bid id
+ * @return index into nodes
+ */
+unsigned int HashTable::bucketOf(uint64_t h) const {
+    return static_cast<unsigned int>(reduceHash(h, tableSize, hashFunction));
+}
+
+/**
+ * Bucket a hash was in before the table grew, only meaningful while oldNodes is in use
+ *
+ * @param h the hash of a bid id
+ * @return index into oldNodes
+ */
+unsigned int HashTable::oldBucketOf(uint64_t h) const {
+    return static_cast<unsigned int>(reduceHash(h, oldSize, hashFunction));
+}
+
+/**
+ * Smallest prime >= n. Prime table sizes keep the modulo hash
+ * from lining up with patterns in the ids.
+ *
+ * @param n where to start looking
+ * @return the prime
+ */
+unsigned int HashTable::nextPrime(unsigned int n) {
+    if (n <= 2) {
+        return 2;
+    }
+    if (n % 2 == 0) {
+        ++n;
+    }
+    while (true) {
+        bool prime = true;
+        for (unsigned int d = 3; (unsigned long long) d * d <= n; d += 2) {
+            if (n % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime) {
+            return n;
+        }
+        n += 2;
+    }
+}
+
+/**
+ * Move every bid into a table of newSize buckets
+ *
+ * Nodes are relinked into their new bucket rather than copied. With
+ * incremental rehashing on, this only swaps the arrays and the bids move
+ * over a few buckets at a time in migrateStep().
+ *
+ * @param newSize the new number of buckets
+ */
+void HashTable::rehash(unsigned int newSize) {
+    // only one old array at a time
+    finishMigration();
+
+    oldNodes.swap(nodes);
+    oldSize = tableSize;
+    migrated = 0;
+    tableSize = newSize;
+    nodes.assign(tableSize, NONE);
+
+    if (!incremental) {
+        finishMigration();
+    }
+}
+
+/**
+ * Move the list in one bucket of oldNodes into nodes
+ *
+ * @param i index into oldNodes
+ */
+void HashTable::migrateBucket(unsigned int i) {
+    int32_t current = oldNodes[i];
+    oldNodes[i] = NONE;
+    while (current != NONE) {
+        int32_t next = entries[current].next;
+        relink(current);
+        current = next;
+    }
+}
+
+/**
+ * One bounded piece of a running migration: MIGRATE_BUCKETS buckets that
+ * hold bids, and no more than ten times that many empty ones
+ * (a mostly empty old array shouldn't make one call expensive either).
+ */
+void HashTable::migrateStep() {
+    if (oldNodes.empty()) {
+        return;
+    }
+
+    unsigned int moved = 0;
+    unsigned int visited = 0;
+    while (migrated < oldSize && moved < MIGRATE_BUCKETS && visited < MIGRATE_BUCKETS * 10) {
+        if (oldNodes[migrated] != NONE) {
+            migrateBucket(migrated);
+            ++moved;
+        }
+        ++migrated;
+        ++visited;
+    }
+
+    if (migrated == oldSize) {
+        vector<int32_t>().swap(oldNodes);
+        oldSize = 0;
+    }
+}
+
+/**
+ * Move whatever is left of a running migration in one go
+ */
+void HashTable::finishMigration() {
+    for (; migrated < oldSize; ++migrated) {
+        migrateBucket(migrated);
+    }
+    vector<int32_t>().swap(oldNodes);
+    oldSize = 0;
+}
+
+/**
+ * Switch incremental rehashing on or off. Switching it off finishes a running migration.
+ *
+ * @param on true to spread growing over the following operations
+ */
+void HashTable::setIncrementalRehash(bool on) {
+    incremental = on;
+    if (!on) {
+        finishMigration();
+    }
+}
+
+/**
+ * Link an entry into its bucket's list in nodes, in front of the first entry
+ * that comes after it in entries. So the list stays in insertion order (and
+ * the first of two bids with the same id stays first), even if the bucket
+ * already has bids from other old buckets or ones Insert put there mid-migration.
+ *
+ * @param entry index of the entry to move, its next gets overwritten
+ */
+void HashTable::relink(int32_t entry) {
+    Node& node = entries[entry];
+    unsigned int key = bucketOf(node.hash);
+    node.key = key;
+    int32_t* link = &nodes[key];
+    while (*link != NONE && *link < entry) {
+        link = &entries[*link].next;
+    }
+    node.next = *link;
+    *link = entry;
+}
+
+/**
+ * Close up the holes Erase left in entries, keeping the order, and link
+ * every list again (the indices all moved)
+ */
+void HashTable::compactEntries() {
+    finishMigration();
+    entries.erase(remove_if(entries.begin(), entries.end(),
+                            [](const Node& entry) { return entry.next == REMOVED; }),
+                  entries.end());
+    removed = 0;
+
+    // going backwards, every entry is the earliest one in its list so far and goes straight in at the front
+    nodes.assign(tableSize, NONE);
+    for (size_t i = entries.size(); i-- > 0;) {
+        relink(static_cast<int32_t>(i));
+    }
+}
+
+/**
+ * Make sure n bids fit without going over MAX_LOAD_FACTOR
+ *
+ * @param n the number of bids expected
+ */
+void HashTable::reserve(size_t n) {
+    // room for the new bids at the end of entries, so it doesn't get copied over and over while loading
+    entries.reserve(n + removed);
+
+    if (n <= tableSize * MAX_LOAD_FACTOR) {
+        return;
+    }
+    rehash(nextPrime(static_cast<unsigned int>(n / MAX_LOAD_FACTOR) + 1));
+
+    // reserve is called before a bulk load, that's the time to pay for the whole move
+    finishMigration();
 }
 
 /**
@@ -184,36 +623,42 @@ void HashTable::Insert(Bid bid) {
     //it is stored as a string in the Bid structure, so we need to convert string to int
 
 
-    //in order to convert string to int using the "atoi" function, need to convert string to constant char
-    //The starter code seems to want me to use atoi... but atoi won't report conversion errors.
-    //I'm going to use strtol instead, for better error handling
-    string bidIDstring = bid.bidId;
-    char* endPtr; //can be used in error handling to find the first invalid character
-    long keyLong = strtol(bidIDstring.c_str(), &endPtr, 10);
-    int bidIDint = static_cast<int>(keyLong);
+    //(the string used to be converted to an int with strtol first, now hash() works on the characters)
 
-    unsigned int key = hash(bidIDint);
+    // grow before the chains get long, doubling keeps the rehashing cost constant per bid
+    if (count + 1 > tableSize * MAX_LOAD_FACTOR) {
+        rehash(nextPrime(tableSize * 2));
+    }
+    ++count;
+    migrateStep();
 
-    // retrieve node using key... the address of "current" is assigned to the address of the node holding the key
-    Node* current = &nodes[key];
+    uint64_t h = hash(bid.bidId);
+    unsigned int key = bucketOf(h);
 
+    // retrieve the list for that key
+    int32_t current = nodes[key];
+    int32_t newNode = static_cast<int32_t>(entries.size());
+    entries.emplace_back(std::move(bid), h, key);
+    //note that the node goes at the end of entries, the list only gets its index
 
-    // if the node for that key is default, then a bid hasn't yet been inserted there
-    if (current->key == UINT_MAX) { //UINT_MAX is assigned in the default constructor...
-        // fill this node with the bid  data
-        current->bid = bid;
-        current->key = key;
-        current->next = nullptr; //the node was previously default, so collision occurs
+    // if the list for that key is empty, then a bid hasn't yet been inserted there
+    if (current == NONE) {
+        nodes[key] = newNode;
+    }
+    else { // COLLISION ALERT! List already has at least 1 bid
+        // Chaining technique: Iterate to the end of the linked list
+        while (entries[current].next != NONE) {
+            current = entries[current].next;
+        }
+        //now that we've found the end of the linked list, "append" the new node (link to next)
+        entries[current].next = newNode;
     }
-    else { // COLLISION ALERT! Node has already been accessed with at least 1 bid
-        // Chaining technique: Iterate to the end of the linked list, looking for the next open node
-        while (current->next != nullptr) {
-            current = current->next;
+
+    if (filter) {
+        filter->addHash(h);
+        if (filter->overfull()) {
+            rebuildFilter(); // grown past what it was sized for, resize before the false positives pile up
         }
-        //now that we've found the end of the linked list, let's make a new node to "append" (link to next)
-        //also note that because we're using "new", dynamically allocating memory, we need to "delete" later
-        Node* newNode = new Node(bid, key);
-        current->next = newNode;
     }
 }
 
@@ -222,21 +667,13 @@ void HashTable::Insert(Bid bid) {
  */
 void HashTable::PrintAll() {
     // FIXME (6): Implement logic to print all bids
-    for (unsigned int i = 0; i < tableSize; ++i) { //for each node in the vector...
-        Node* current = &nodes[i];  //starting with node 0...
-        if (current->key != UINT_MAX) { //if the bid key is non-default (aka if it's populated with a bid)
-            //then print bid data!
+    // (this used to go list by list through every bucket, now it's straight down entries, in insertion order)
+    for (const Node& current : entries) {
+        if (current.next != REMOVED) {
             // output key, bidID, title, amount and fund
-            cout << "Key: " << current->key << ";  ";
-            cout << "Bid ID: ";
-            displayBid(current->bid);  //note: displayBid will should ID, title, amount, and fund
-        }
-        current = current->next;
-        while (current != nullptr) { //check if there's a link list... if there is, print those bids too
-            cout << "Key: " << current->key << ";  ";
+            cout << "Key: " << current.key << ";  ";
             cout << "Bid ID: ";
-            displayBid(current->bid);
-            current = current->next;
+            displayBid(current.bid);  //note: displayBid will should ID, title, amount, and fund
         }
     }
 }
@@ -248,83 +685,81 @@ void HashTable::PrintAll() {
  */
 void HashTable::Remove(string bidId) {
     // FIXME (7): Implement logic to remove a bid
-    char* endPtr; //can be used in error handling to find the first invalid character
-    long keyLong = strtol(bidId.c_str(), &endPtr, 10);
-    int bidIDint = static_cast<int>(keyLong);
-    unsigned int key = hash(bidIDint);
+    //the actual removing is in Erase() now, this just says how it went
+    if (Erase(bidId)) {
+        cout << "Successfully removed bid ID# " << bidId << endl;
+    } else {
+        //of course, it's possible that the passed bidID argument was never entered into the hash table...
+        cout << "Bid with ID# " << bidId << " not found in hash table." << endl;
+    }
+}
+
+/**
+ * Remove a bid without printing anything
+ *
+ * @param bidId The bid id to remove
+ * @return true if it was there
+ */
+bool HashTable::Erase(string_view bidId) {
+    // if the table is growing and the bid's old bucket hasn't moved yet, move it now so only "nodes" needs handling
+    uint64_t h = hash(bidId);
+    migrateStep();
+    if (filter && !filter->mayContainHash(h)) {
+        return false;
+    }
+    if (!oldNodes.empty()) {
+        migrateBucket(oldBucketOf(h));
+    }
+
+    unsigned int key = bucketOf(h);
 
     //The key will tell us where to look, within the vector called "nodes"
     //but if any collisions occurred, it's possible that this bid is part of a linked list stemming from it's key node
     //so we need to be careful about preserving the list...
     // We want to delete just the one bid, not all bids whose IDs hashed to the same key
 
-    Node* current = &nodes[key]; //first, navigate to the head node associated with the hash key
-    //note, it doesn't matter if this node was populated with a real bid, or just default
-    //we initialized all nodes when we created the hash table, so there is a valid address to each Node in nodes
+    int32_t current = nodes[key]; //first, navigate to the head node associated with the hash key
+    //note, it might be NONE if no bid ever landed there
 
-    Node* prev = nullptr; //initialize this for later use
+    int32_t prev = NONE; //initialize this for later use
 
-
-    bool needToDeleteCurrent = false;
-
-    /*********** THREE SCENARIOS
-     *  1. The bid exists within the node at nodes[key], and there are no prior collisions (linked list is empty).
-        2. The bid exists within the node at nodes[key], and there is a linked list (collision occurred).
-        3. The bid is within a linked list at nodes[key], and it's not the first node in the list.
+    /*********** TWO SCENARIOS
+     *  1. The bid is the first node in the list at nodes[key], the list now starts at the second node (or is empty).
+        2. The bid is further down the list at nodes[key], the node before it skips over it.
      ****************/
 
-    while (current != nullptr) { //while we haven't hit the tail of the list:
-        if (current->bid.bidId == bidId) {//if we find the node associated with the passed bidID...
-
-            if (prev != nullptr) { //this "if" will never be True the first time we enter the while loop
+    while (current != NONE) { //while we haven't hit the tail of the list:
+        Node& node = entries[current];
+        if (node.hash == h && node.bid.bidId == bidId) {//if we find the node associated with the passed bidID...
 
+            if (prev != NONE) { //this "if" will never be True the first time we enter the while loop
                 // Bid is not the first node in the linked list
                 // let's cut out the target bid, while preserving the linked list
-                prev->next = current->next;
-                needToDeleteCurrent = true;
+                entries[prev].next = node.next;
             }
-            else { // Bid is the first node in the linked list, because prev == nullptr
-                if (current->next != nullptr) { //if a linked list exists in this node...
-                    // If there's a next node, let's have the head point to the second node in the linked list
-                    // this step bypasses the target bid node
-
-                    Node* temp = current->next;  // Save the address of the second node
-                    nodes[key] = *temp; //nodes[key] gets filled with the bid that is at address "temp"
-                    //so now, if target bid was the first node, and nodes[key] contains the contents of the second now,
-                    //then nodes[key].next should still point to the third node.
-                    current = temp;
-
-                    needToDeleteCurrent = true;
-                }
-                else {
-                    // If there's no next node, replace the target bid node with a default-constructed node
-                    nodes[key] = Node();
-                    //at this point, current still points to the nodes[key] Node... just now it's a default node
-                    //don't want to delete current, we still want that node to exist
-                    needToDeleteCurrent = false;
-                }
+            else { // Bid is the first node in the linked list, because prev == NONE
+                nodes[key] = node.next;
             }
 
-            if(needToDeleteCurrent){
-                //if the target bid was in a linked list with 2 or more nodes,
-                //we want to delete the node that held the target bid to free up memory
-                //we do not want to delete the node if no linked list existed, because that would mess up the hashtable
-                delete current;
+            //either way, nothing points at the target bid's node anymore, so it's a hole in entries now
+            //(bid and all, freeing the strings one node at a time was most of the cost of removing)
+            //and the holes get closed up once there are more of them than bids
+            node.next = REMOVED;
+            ++removed;
+            --count;
+            if (removed > count && removed >= DEFAULT_SIZE) {
+                compactEntries();
             }
-
-            cout << "Successfully removed bid ID# " << bidId << endl;
-            return; //not returning anything, it's void. But this stops the function from continuing.
+            return true;
 
         }//if
 
         //we didn't find the bid node on this pass. Traverse to the next node in the list and try again.
         prev = current;
-        current = current->next;
+        current = node.next;
     }
 
-    //of course, it's possible that the passed bidID argument was never entered into the hash table...
-    cout << "Bid with ID# " << bidId << " not found in hash table." << endl;
-
+    return false;
 }
 
 /**
@@ -337,23 +772,11 @@ Bid HashTable::Search(string bidId) {
 
     // FIXME (8): Implement logic to search for and return a bid
     //I think this is going to look very similar to the "remove" function I just made...
-
-    // create the key for the given bid
-    char* endPtr; //can be used in error handling to find the first invalid character
-    long keyLong = strtol(bidId.c_str(), &endPtr, 10);
-    int bidIDint = static_cast<int>(keyLong);
-    unsigned int key = hash(bidIDint);
-
-    //first, navigate to the head node associated with the hash key
-    Node* current = &nodes[key];
-
-    //let's while-loop down the linked list:
-    while (current != nullptr) { //while we haven't hit the tail of the list:
-        if (current->bid.bidId == bidId) {
-            cout << "Ladies and gentlemen, we got 'em... found bid ID# " << bidId << endl;
-            return current->bid;
-        }
-        current = current->next;
+    //(the looking is in Find() now, Search adds the messages and the copy)
+    const Bid* found = Find(bidId);
+    if (found != nullptr) {
+        cout << "Ladies and gentlemen, we got 'em... found bid ID# " << bidId << endl;
+        return *found;
     }
 
     cout << "Error: bid ID# " << bidId << " not found." << endl;
@@ -361,91 +784,2507 @@ Bid HashTable::Search(string bidId) {
     return blankBid;
 }
 
-//============================================================================
-// Static methods used for testing
-//============================================================================
-
 /**
- * Display the bid information to the console (std::out)
+ * How long the lists are
  *
- * @param bid struct containing the bid info
+ * @return entry i is the number of buckets with a list of i bids
  */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-         << bid.fund << endl;
+vector<size_t> HashTable::chainLengths() const {
+    vector<size_t> histogram;
+    for (const vector<int32_t>* table : {&nodes, &oldNodes}) {
+        for (int32_t current : *table) {
+            size_t length = 0;
+            for (; current != NONE; current = entries[current].next) {
+                ++length;
+            }
+            if (length >= histogram.size()) {
+                histogram.resize(length + 1, 0);
+            }
+            ++histogram[length];
+        }
+    }
+    return histogram;
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Put a Bloom filter in front of the table, filled with the bids already in it.
+ * From then on Insert keeps it up to date.
  *
- * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
+ * @param bitsPerKey filter memory per bid it has room for, 10 bits is about a 1% false positive
+ *                   once it fills up (it starts out sized for twice the bids in the table)
  */
-void loadBids(string csvPath, HashTable* hashTable) {
-    cout << "Loading CSV file " << csvPath << endl;
-
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+void HashTable::enableFilter(double bitsPerKey) {
+    filter.reset(new BloomFilter(0, bitsPerKey));
+    rebuildFilter();
+}
 
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+/**
+ * Refill the filter from the bids in the table. Removed bids stay "maybe there"
+ * in the filter until this runs, and it's sized for twice the current count,
+ * so Insert doesn't need to call it again any time soon.
+ */
+void HashTable::rebuildFilter() {
+    if (!filter) {
+        return;
     }
-    cout << "" << endl;
-
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
-
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+    filter->reset(max(count * 2, (size_t) DEFAULT_SIZE));
+    for (const Node& entry : entries) {
+        if (entry.next != REMOVED) {
+            filter->addHash(entry.hash);
+        }
+    }
+}
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+/**
+ * Search for a bid without printing anything or copying it
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or nullptr if it isn't there. Only good until the table changes.
+ */
+const Bid* HashTable::Find(string_view bidId) {
+    migrateStep();
+    uint64_t h = hash(bidId);
+    if (filter && !filter->mayContainHash(h)) {
+        return nullptr; // definitely not here, and that only took one cache line
+    }
+    int32_t node = findNode(bidId, h);
+    return node != NONE ? &entries[node].bid : nullptr;
+}
 
-            // push this bid to the end
-            hashTable->Insert(bid);
+/**
+ * Look a bid id up in nodes, and in oldNodes while a migration is running
+ *
+ * @return the node's index in entries, or NONE
+ */
+int32_t HashTable::findNode(string_view bidId, uint64_t h) const {
+    // oldNodes first: whatever hasn't moved yet went in before anything Insert has put in nodes
+    // since the migration started, and the first bid with an id is the one that counts
+    if (!oldNodes.empty()) {
+        for (int32_t current = oldNodes[oldBucketOf(h)]; current != NONE; current = entries[current].next) {
+            if (entries[current].hash == h && entries[current].bid.bidId == bidId) {
+                return current;
+            }
+        }
+    }
+    for (int32_t current = nodes[bucketOf(h)]; current != NONE; current = entries[current].next) {
+        if (entries[current].hash == h && entries[current].bid.bidId == bidId) {
+            return current;
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
     }
+    return NONE;
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Look up a lot of bid ids at once, without printing anything
  *
- * credit: http://stackoverflow.com/a/24875936
+ * Search finds one bid at a time, so every bucket and every node it touches is
+ * a cache miss it sits and waits for. This goes through the ids BATCH_GROUP at a
+ * time in three passes: hash them all and prefetch their buckets, then read the
+ * bucket heads and prefetch the first nodes, then walk the lists. By the time a
+ * pass gets to a key its memory is (hopefully) already on the way.
  *
- * @param ch The character to strip out
+ * @param bidIds the ids to look up
+ * @param found gets a pointer to each bid, or nullptr if it isn't in the table.
+ *        The pointers stay good until the table is changed. Only the first
+ *        min(bidIds.size(), found.size()) ids get looked up.
+ * @return how many were found
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+size_t HashTable::SearchBatch(span<const string_view> bidIds, span<const Bid*> found) {
+    migrateStep();
+
+    size_t n = min(bidIds.size(), found.size());
+    size_t hits = 0;
+    uint64_t hashes[BATCH_GROUP];
+    int32_t heads[BATCH_GROUP];
+
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t group = min(BATCH_GROUP, n - start);
+
+        bool maybe[BATCH_GROUP];
+        for (size_t i = 0; i < group; ++i) {
+            hashes[i] = hash(bidIds[start + i]);
+            maybe[i] = !filter || filter->mayContainHash(hashes[i]);
+            if (maybe[i]) {
+                prefetch(&nodes[bucketOf(hashes[i])]);
+            }
+        }
+        for (size_t i = 0; i < group; ++i) {
+            heads[i] = maybe[i] ? nodes[bucketOf(hashes[i])] : NONE;
+            if (heads[i] != NONE) {
+                prefetch(&entries[heads[i]]);
+            }
+        }
+        for (size_t i = 0; i < group; ++i) {
+            int32_t node = NONE;
+            if (!maybe[i]) {
+                // the filter already said no
+            } else if (oldNodes.empty()) {
+                for (int32_t current = heads[i]; current != NONE; current = entries[current].next) {
+                    if (entries[current].hash == hashes[i] && entries[current].bid.bidId == bidIds[start + i]) {
+                        node = current;
+                        break;
+                    }
+                }
+            } else {
+                node = findNode(bidIds[start + i], hashes[i]); // mid-rehash, it may be in either array
+            }
+            found[start + i] = node != NONE ? &entries[node].bid : nullptr;
+            hits += node != NONE;
+        }
+    }
+    return hits;
 }
 
+//============================================================================
+// OpenHashTable class definition
+//============================================================================
+
 /**
- * The one and only main() method
+ * Hash table with open addressing and Robin Hood probing.
+ *
+ * There are no nodes and no next pointers: every bid lives directly in one flat
+ * array of slots, and a collision just moves on to the next slot. On the way, an
+ * entry that's further from its home slot than the one sitting there takes the
+ * slot ("robs the rich") and the displaced one keeps walking, which keeps every
+ * probe sequence short. Remove shifts the following entries back one slot
+ * instead of leaving tombstones.
+ *
+ * Probe distances and hashes sit in their own small arrays, so a probe only
+ * touches the (big) bids array once the hash already matches.
+ *
+ * The slots only ever hold one bid per id, the oldest. Later bids with the same
+ * id wait in "repeats" until the one in front of them is removed. Putting them
+ * in slots too would make every copy of one id share a home slot, and a few
+ * hundred of them (blank ids, say) would push probe distances past what fits in
+ * a byte however big the table got.
  */
-int main(int argc, char* argv[]) {
+class OpenHashTable : public BidTable {
 
-    // process command line arguments
-    string csvPath, bidKey;
-    switch (argc) {
-        case 2:
-            csvPath = argv[1];
-            bidKey = "98109";
-            break;
-        case 3:
-            csvPath = argv[1];
-            bidKey = argv[2];
-            break;
-        default:
-            csvPath = "eBid_Monthly_Sales_Dec_2016.csv";
+private:
+    vector<Bid> bids;                // the slots
+    vector<uint64_t> hashes;         // full hash of the bid id in each slot
+    vector<uint8_t> distances;       // probe distance + 1, 0 means the slot is empty
+    size_t mask = 0;                 // capacity - 1, capacity is always a power of two
+    size_t count = 0;                // bids stored, repeats included
+    unordered_map<string, deque<Bid>> repeats; // second and later bids for an id in a slot, oldest first
+
+    HashFunction hashFunction = eWYHASH;
+
+    static const uint8_t MAX_DISTANCE = 255;
+
+    size_t home(uint64_t h) const { return reduceHash(h, mask + 1, hashFunction); }
+    void grow();
+    void resize(size_t slots);
+    void place(Bid bid, uint64_t h);
+    size_t find(string_view bidId, uint64_t h) const;
+
+public:
+    OpenHashTable();
+    OpenHashTable(size_t size, HashFunction function = eWYHASH);
+    void Insert(Bid bid) override;
+    void PrintAll() override;
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void reserve(size_t n) override;
+    size_t size() const override { return count; }
+    size_t capacity() const { return mask + 1; }
+    vector<size_t> probeLengths() const;
+    const Bid* Find(string_view bidId) const;
+    bool Erase(string_view bidId);
+};
+
+/**
+ * Default constructor, room for DEFAULT_SIZE bids before the first grow
+ */
+OpenHashTable::OpenHashTable() : OpenHashTable(DEFAULT_SIZE) {}
+
+/**
+ * Constructor for specifying how many bids to make room for
+ *
+ * @param size number of bids expected, rounded up so the load stays under 7/8
+ * @param function the hash function, it can't change once bids are in
+ */
+OpenHashTable::OpenHashTable(size_t size, HashFunction function) : hashFunction(function) {
+    size_t slots = 16;
+    while (slots * 7 / 8 < size) {
+        slots *= 2;
+    }
+    bids.resize(slots);
+    hashes.resize(slots);
+    distances.resize(slots, 0);
+    mask = slots - 1;
+}
+
+/**
+ * Double the capacity
+ */
+void OpenHashTable::grow() {
+    resize((mask + 1) * 2);
+}
+
+/**
+ * Move every bid into a table of the given number of slots
+ *
+ * @param slots new capacity, a power of two with room for all the bids
+ */
+void OpenHashTable::resize(size_t slots) {
+    vector<Bid> oldBids;
+    vector<uint64_t> oldHashes;
+    vector<uint8_t> oldDistances;
+    oldBids.swap(bids);
+    oldHashes.swap(hashes);
+    oldDistances.swap(distances);
+
+    bids.resize(slots);
+    hashes.resize(slots);
+    distances.resize(slots, 0);
+    mask = slots - 1;
+
+    // the repeats don't move, so the count ends up where it started
+    size_t stored = count;
+    count = 0;
+    for (size_t i = 0; i < oldBids.size(); ++i) {
+        if (oldDistances[i] != 0) {
+            place(std::move(oldBids[i]), oldHashes[i]);
+        }
+    }
+    count = stored;
+}
+
+/**
+ * Robin Hood insert of one bid. If its id is already in a slot, the bid goes
+ * to the back of that id's repeats instead.
+ * If a probe distance would no longer fit in a byte, the table grows first.
+ */
+void OpenHashTable::place(Bid bid, uint64_t h) {
+    size_t slot = home(h);
+    unsigned int distance = 1;
+    bool swapped = false; // once we've swapped, we're carrying some other bid that's already unique
+
+    while (true) {
+        if (distances[slot] == 0) {
+            bids[slot] = std::move(bid);
+            hashes[slot] = h;
+            distances[slot] = static_cast<uint8_t>(distance);
+            ++count;
+            return;
+        }
+
+        if (!swapped && hashes[slot] == h && bids[slot].bidId == bid.bidId) {
+            repeats[bid.bidId].push_back(std::move(bid));
+            ++count;
+            return;
+        }
+
+        if (distances[slot] < distance) {
+            // the bid sitting here is closer to home than we are, it moves on instead
+            swap(bids[slot], bid);
+            swap(hashes[slot], h);
+            uint8_t d = distances[slot];
+            distances[slot] = static_cast<uint8_t>(distance);
+            distance = d;
+            swapped = true;
+        }
+
+        slot = (slot + 1) & mask;
+        if (++distance >= MAX_DISTANCE) {
+            // whatever we're carrying goes into the bigger table
+            grow();
+            place(std::move(bid), h);
+            return;
+        }
+    }
+}
+
+/**
+ * Find the slot holding a bid id
+ *
+ * @return the slot, or SIZE_MAX if the bid isn't in the table
+ */
+size_t OpenHashTable::find(string_view bidId, uint64_t h) const {
+    size_t slot = home(h);
+    unsigned int distance = 1;
+
+    // an entry that's closer to home than we'd be means our bid would have taken this slot, so it's not here
+    while (distances[slot] >= distance) {
+        if (hashes[slot] == h && bids[slot].bidId == bidId) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+        ++distance;
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * Insert a bid
+ *
+ * @param bid The bid to insert
+ */
+void OpenHashTable::Insert(Bid bid) {
+    // keep the load under 7/8, past that the probe sequences get long
+    if ((count + 1) * 8 > (mask + 1) * 7) {
+        grow();
+    }
+    uint64_t h = hashKey(bid.bidId, hashFunction);
+    place(std::move(bid), h);
+}
+
+/**
+ * Make sure n bids fit without going over 7/8 load
+ *
+ * @param n the number of bids expected
+ */
+void OpenHashTable::reserve(size_t n) {
+    size_t slots = mask + 1;
+    while (slots * 7 / 8 < n) {
+        slots *= 2;
+    }
+    if (slots != mask + 1) {
+        resize(slots);
+    }
+}
+
+/**
+ * Print all bids
+ */
+void OpenHashTable::PrintAll() {
+    for (size_t i = 0; i <= mask; ++i) {
+        if (distances[i] != 0) {
+            cout << "Key: " << i << ";  ";
+            cout << "Bid ID: ";
+            displayBid(bids[i]);
+
+            auto later = repeats.empty() ? repeats.end() : repeats.find(bids[i].bidId);
+            if (later != repeats.end()) {
+                for (const Bid& bid : later->second) {
+                    cout << "Key: " << i << ";  ";
+                    cout << "Bid ID: ";
+                    displayBid(bid);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to search for
+ */
+void OpenHashTable::Remove(string bidId) {
+    if (Erase(bidId)) {
+        cout << "Successfully removed bid ID# " << bidId << endl;
+    } else {
+        cout << "Bid with ID# " << bidId << " not found in hash table." << endl;
+    }
+}
+
+/**
+ * Remove a bid without printing anything
+ *
+ * @param bidId The bid id to remove
+ * @return true if it was there
+ */
+bool OpenHashTable::Erase(string_view bidId) {
+    size_t slot = find(bidId, hashKey(bidId, hashFunction));
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+
+    // the next bid with this id (if there is one) takes the slot over
+    auto later = repeats.empty() ? repeats.end() : repeats.find(bids[slot].bidId);
+    if (later != repeats.end()) {
+        bids[slot] = std::move(later->second.front());
+        later->second.pop_front();
+        if (later->second.empty()) {
+            repeats.erase(later);
+        }
+        --count;
+        return true;
+    }
+
+    // backward shift: pull every following entry that isn't already home one slot closer
+    size_t next = (slot + 1) & mask;
+    while (distances[next] > 1) {
+        bids[slot] = std::move(bids[next]);
+        hashes[slot] = hashes[next];
+        distances[slot] = distances[next] - 1;
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    bids[slot] = Bid();
+    distances[slot] = 0;
+    --count;
+    return true;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid OpenHashTable::Search(string bidId) {
+    const Bid* found = Find(bidId);
+    if (found == nullptr) {
+        cout << "Error: bid ID# " << bidId << " not found." << endl;
+        return Bid();
+    }
+    cout << "Ladies and gentlemen, we got 'em... found bid ID# " << bidId << endl;
+    return *found;
+}
+
+/**
+ * Search for a bid without printing anything or copying it
+ *
+ * @param bidId The bid id to search for
+ * @return the bid, or nullptr if it isn't there. Only good until the table changes.
+ */
+const Bid* OpenHashTable::Find(string_view bidId) const {
+    size_t slot = find(bidId, hashKey(bidId, hashFunction));
+    return slot != SIZE_MAX ? &bids[slot] : nullptr;
+}
+
+/**
+ * How far bids are from their home slot
+ *
+ * @return entry i is the number of bids found after probing i+1 slots
+ */
+vector<size_t> OpenHashTable::probeLengths() const {
+    vector<size_t> histogram;
+    for (uint8_t distance : distances) {
+        if (distance == 0) {
+            continue;
+        }
+        if (distance > histogram.size()) {
+            histogram.resize(distance, 0);
+        }
+        ++histogram[distance - 1];
+    }
+    return histogram;
+}
+
+//============================================================================
+// ConcurrentHashTable class definition
+//============================================================================
+
+/**
+ * Chained hash table that many threads can search while others insert and remove
+ *
+ * Writers lock one of STRIPES mutexes, picked from the bid id's hash so it's the
+ * same stripe whatever the table size (sizes are powers of two, at least
+ * STRIPES). Growing takes every stripe and builds the new bucket array out of
+ * copies of the nodes, so the old chains never change under a reader.
+ *
+ * Readers don't lock anything. The next pointers are atomics and a node is
+ * fully built before it's published, so a reader always sees a consistent
+ * chain. What keeps the nodes alive under it is epoch based reclamation: a
+ * reader writes the current epoch into its own slot while it's in the table,
+ * and removed nodes (and old bucket arrays) only get freed once every reader
+ * still inside arrived after they were unlinked. A thread that can't get one of
+ * the MAX_READERS slots falls back to reading under its stripe's lock.
+ */
+class ConcurrentHashTable : public BidTable {
+
+private:
+    struct Node {
+        Bid bid;
+        uint64_t hash;
+        atomic<Node*> next;
+
+        Node(Bid aBid, uint64_t aHash, Node* aNext) : bid(std::move(aBid)), hash(aHash), next(aNext) {}
+    };
+
+    struct Buckets {
+        size_t size;
+        unique_ptr<atomic<Node*>[]> heads;
+
+        explicit Buckets(size_t n) : size(n), heads(new atomic<Node*>[n]) {
+            for (size_t i = 0; i < n; ++i) {
+                heads[i].store(nullptr, memory_order_relaxed);
+            }
+        }
+    };
+
+    // something unlinked at "epoch", to be freed once no reader can still be looking at it
+    struct Retired {
+        uint64_t epoch;
+        Node* node;       // a removed node, or
+        Buckets* buckets; // a whole old bucket array, chains included
+    };
+
+    // each on its own cache line, so threads working on different stripes/slots don't fight over one
+    struct alignas(64) Stripe {
+        mutex lock;
+    };
+
+    struct alignas(64) ReaderEpoch {
+        atomic<uint64_t> epoch{0}; // 0 when the reader isn't in the table
+    };
+
+    static constexpr size_t STRIPES = 64;
+    static constexpr size_t MAX_READERS = 128;
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+    HashFunction hashFunction;
+    atomic<Buckets*> buckets;
+    atomic<size_t> count{0};
+    Stripe stripes[STRIPES];
+
+    atomic<uint64_t> epoch{1};
+    ReaderEpoch readers[MAX_READERS];
+    mutex retiredLock;
+    vector<Retired> retired;
+
+    static int readerSlot();
+    static void freeBuckets(Buckets* old);
+    mutex& stripeOf(uint64_t h) { return stripes[reduceHash(h, STRIPES, hashFunction)].lock; }
+    size_t bucketOf(uint64_t h, const Buckets* b) const { return reduceHash(h, b->size, hashFunction); }
+    void retire(Node* node, Buckets* old);
+    void reclaim();
+    void grow(size_t newSize);
+    bool findIn(const Buckets* b, uint64_t h, string_view bidId, Bid& bid) const;
+
+public:
+    ConcurrentHashTable(size_t size = DEFAULT_SIZE, HashFunction function = eWYHASH);
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+    virtual ~ConcurrentHashTable();
+    void Insert(Bid bid) override;
+    void PrintAll() override;
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void reserve(size_t n) override;
+    size_t size() const override { return count.load(memory_order_relaxed); }
+    bool Find(string_view bidId, Bid& bid);
+    bool Erase(string_view bidId);
+};
+
+/**
+ * Constructor
+ *
+ * @param size number of buckets to start with, rounded up to a power of two (and at least STRIPES)
+ * @param function the hash function
+ */
+ConcurrentHashTable::ConcurrentHashTable(size_t size, HashFunction function) : hashFunction(function) {
+    size_t n = STRIPES;
+    while (n < size) {
+        n *= 2;
+    }
+    buckets.store(new Buckets(n));
+}
+
+/**
+ * Destructor, nobody can be reading anymore so everything goes
+ */
+ConcurrentHashTable::~ConcurrentHashTable() {
+    freeBuckets(buckets.load());
+    for (Retired& r : retired) {
+        delete r.node;
+        freeBuckets(r.buckets);
+    }
+}
+
+/**
+ * Delete a bucket array and every node still linked in it
+ */
+void ConcurrentHashTable::freeBuckets(Buckets* old) {
+    if (old == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < old->size; ++i) {
+        Node* current = old->heads[i].load(memory_order_relaxed);
+        while (current != nullptr) {
+            Node* next = current->next.load(memory_order_relaxed);
+            delete current;
+            current = next;
+        }
+    }
+    delete old;
+}
+
+/**
+ * This thread's reader slot, the same one in every ConcurrentHashTable
+ *
+ * @return slot index, or -1 if all MAX_READERS slots are taken
+ */
+int ConcurrentHashTable::readerSlot() {
+    static atomic<bool> taken[MAX_READERS];
+
+    // gives the slot back when the thread ends
+    struct Registration {
+        int slot = -2; // -2 not registered yet, -1 no slot free
+        ~Registration() {
+            if (slot >= 0) {
+                taken[slot].store(false);
+            }
+        }
+    };
+    thread_local Registration registration;
+
+    if (registration.slot == -2) {
+        registration.slot = -1;
+        for (size_t i = 0; i < MAX_READERS; ++i) {
+            if (!taken[i].exchange(true)) {
+                registration.slot = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    return registration.slot;
+}
+
+/**
+ * Hand something that was just unlinked over for freeing later
+ *
+ * @param node a node, or nullptr
+ * @param old a bucket array, or nullptr
+ */
+void ConcurrentHashTable::retire(Node* node, Buckets* old) {
+    lock_guard<mutex> guard(retiredLock);
+    // readers that show up after this epoch can't reach what was unlinked before it
+    retired.push_back(Retired{epoch.fetch_add(1), node, old});
+    if (retired.size() >= RECLAIM_BATCH || old != nullptr) {
+        reclaim();
+    }
+}
+
+/**
+ * Free everything that was retired before the oldest reader still in the table
+ * got there. Called with retiredLock held.
+ */
+void ConcurrentHashTable::reclaim() {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (ReaderEpoch& reader : readers) {
+        uint64_t e = reader.epoch.load(memory_order_acquire);
+        if (e != 0 && e < oldest) {
+            oldest = e;
+        }
+    }
+
+    size_t kept = 0;
+    for (Retired& r : retired) {
+        if (r.epoch < oldest) {
+            delete r.node;
+            freeBuckets(r.buckets);
+        } else {
+            retired[kept++] = r;
+        }
+    }
+    retired.resize(kept);
+}
+
+/**
+ * Switch to a bucket array of newSize, unless someone else already grew it that far
+ *
+ * Holds every stripe while it copies, so writers wait, readers don't.
+ *
+ * @param newSize a power of two
+ */
+void ConcurrentHashTable::grow(size_t newSize) {
+    for (Stripe& stripe : stripes) {
+        stripe.lock.lock();
+    }
+
+    Buckets* old = buckets.load(memory_order_relaxed);
+    if (old->size < newSize) {
+        Buckets* fresh = new Buckets(newSize);
+        // copies go on the end of their new chain, so bids with the same id keep their order
+        vector<atomic<Node*>*> tails(newSize);
+        for (size_t i = 0; i < newSize; ++i) {
+            tails[i] = &fresh->heads[i];
+        }
+        for (size_t i = 0; i < old->size; ++i) {
+            for (Node* n = old->heads[i].load(memory_order_relaxed); n != nullptr; n = n->next.load(memory_order_relaxed)) {
+                atomic<Node*>*& tail = tails[bucketOf(n->hash, fresh)];
+                Node* copy = new Node(n->bid, n->hash, nullptr);
+                tail->store(copy, memory_order_relaxed);
+                tail = &copy->next;
+            }
+        }
+        buckets.store(fresh, memory_order_release);
+    } else {
+        old = nullptr;
+    }
+
+    for (Stripe& stripe : stripes) {
+        stripe.lock.unlock();
+    }
+    if (old != nullptr) {
+        retire(nullptr, old);
+    }
+}
+
+/**
+ * Make sure n bids fit without going over MAX_LOAD_FACTOR
+ *
+ * @param n the number of bids expected
+ */
+void ConcurrentHashTable::reserve(size_t n) {
+    size_t size = buckets.load(memory_order_acquire)->size;
+    if (n <= size * MAX_LOAD_FACTOR) {
+        return;
+    }
+    while (n > size * MAX_LOAD_FACTOR) {
+        size *= 2;
+    }
+    grow(size);
+}
+
+/**
+ * Insert a bid, after any bids with the same id
+ *
+ * @param bid The bid to insert
+ */
+void ConcurrentHashTable::Insert(Bid bid) {
+    uint64_t h = hashKey(bid.bidId, hashFunction);
+    mutex& stripe = stripeOf(h);
+    stripe.lock();
+
+    // holding a stripe means the bucket array can't change under us
+    Buckets* b = buckets.load(memory_order_relaxed);
+    atomic<Node*>* link = &b->heads[bucketOf(h, b)];
+
+    // the end of the chain, so a repeated id is found in the order it came in.
+    // A reader sees the new node whole or not at all, same as at the head
+    while (Node* n = link->load(memory_order_relaxed)) {
+        link = &n->next;
+    }
+    link->store(new Node(std::move(bid), h, nullptr), memory_order_release);
+    size_t stored = count.fetch_add(1, memory_order_relaxed) + 1;
+    size_t size = b->size;
+    stripe.unlock();
+
+    if (stored > size * MAX_LOAD_FACTOR) {
+        grow(size * 2);
+    }
+}
+
+/**
+ * Remove a bid without printing anything
+ *
+ * @param bidId The bid id to remove
+ * @return true if it was there
+ */
+bool ConcurrentHashTable::Erase(string_view bidId) {
+    uint64_t h = hashKey(bidId, hashFunction);
+    mutex& stripe = stripeOf(h);
+    stripe.lock();
+
+    Buckets* b = buckets.load(memory_order_relaxed);
+    for (atomic<Node*>* prev = &b->heads[bucketOf(h, b)]; Node* n = prev->load(memory_order_relaxed); prev = &n->next) {
+        if (n->hash == h && n->bid.bidId == bidId) {
+            prev->store(n->next.load(memory_order_relaxed), memory_order_release);
+            count.fetch_sub(1, memory_order_relaxed);
+            stripe.unlock();
+            retire(n, nullptr);
+            return true;
+        }
+    }
+    stripe.unlock();
+    return false;
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to search for
+ */
+void ConcurrentHashTable::Remove(string bidId) {
+    if (Erase(bidId)) {
+        cout << "Successfully removed bid ID# " << bidId << endl;
+    } else {
+        cout << "Bid with ID# " << bidId << " not found in hash table." << endl;
+    }
+}
+
+/**
+ * Walk one chain looking for a bid id, copying the bid out if it's there
+ */
+bool ConcurrentHashTable::findIn(const Buckets* b, uint64_t h, string_view bidId, Bid& bid) const {
+    for (Node* n = b->heads[bucketOf(h, b)].load(memory_order_acquire); n != nullptr; n = n->next.load(memory_order_acquire)) {
+        if (n->hash == h && n->bid.bidId == bidId) {
+            bid = n->bid;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Search without printing anything, and without taking a lock
+ *
+ * Unlike the other tables this hands back a copy: another thread may
+ * remove the bid the moment we're out of the table.
+ *
+ * @param bidId The bid id to search for
+ * @param bid gets a copy of the bid if it's found
+ * @return true if it was found
+ */
+bool ConcurrentHashTable::Find(string_view bidId, Bid& bid) {
+    uint64_t h = hashKey(bidId, hashFunction);
+    int slot = readerSlot();
+
+    if (slot < 0) {
+        // no reader slot for this thread, read like a writer would
+        lock_guard<mutex> guard(stripeOf(h));
+        return findIn(buckets.load(memory_order_relaxed), h, bidId, bid);
+    }
+
+    // announce which epoch we're reading in, before touching a single node
+    ReaderEpoch& reader = readers[slot];
+    reader.epoch.store(epoch.load(memory_order_acquire), memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    bool found = findIn(buckets.load(memory_order_acquire), h, bidId, bid);
+
+    reader.epoch.store(0, memory_order_release);
+    return found;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid ConcurrentHashTable::Search(string bidId) {
+    Bid bid;
+    if (Find(bidId, bid)) {
+        cout << "Ladies and gentlemen, we got 'em... found bid ID# " << bidId << endl;
+    } else {
+        cout << "Error: bid ID# " << bidId << " not found." << endl;
+    }
+    return bid;
+}
+
+/**
+ * Print all bids. Takes every stripe, so it's a consistent snapshot.
+ */
+void ConcurrentHashTable::PrintAll() {
+    for (Stripe& stripe : stripes) {
+        stripe.lock.lock();
+    }
+    Buckets* b = buckets.load(memory_order_relaxed);
+    for (size_t i = 0; i < b->size; ++i) {
+        for (Node* n = b->heads[i].load(memory_order_relaxed); n != nullptr; n = n->next.load(memory_order_relaxed)) {
+            cout << "Key: " << i << ";  ";
+            cout << "Bid ID: ";
+            displayBid(n->bid);
+        }
+    }
+    for (Stripe& stripe : stripes) {
+        stripe.lock.unlock();
+    }
+}
+
+/**
+ * Write a whole file to a temp file next to it, then rename that over it, so
+ * the file is either all old or all new
+ *
+ * @param path the file to replace
+ * @param bytes what goes in it
+ */
+void replaceFile(const string& path, string_view bytes) {
+    string temp = path + ".tmp";
+    ofstream f(temp, ios::out | ios::binary | ios::trunc);
+    f.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    f.close();
+    if (!f) {
+        throw csv::Error("Failed to write " + temp);
+    }
+    error_code ec;
+    filesystem::rename(temp, path, ec);
+    if (ec) {
+        filesystem::remove(temp, ec);
+        throw csv::Error("Failed to replace " + path);
+    }
+}
+
+//============================================================================
+// PerfectHashTable class definition
+//============================================================================
+
+/**
+ * Read-only bid lookup for a month of bids that isn't going to change
+ *
+ * The bids stay in the CSV's snapshot (csv::Table) and a minimal perfect hash
+ * over their ids (BBHash) gives every distinct id its own slot, 0 to n - 1.
+ * So a lookup never collides and never walks a chain: the slot holds the
+ * bid's row, and the row's id only gets compared to tell the ids that were
+ * never loaded apart.
+ *
+ * The hash is a few bit arrays ("levels"). Every id that lands alone on its bit
+ * in level 0 sets it, the ones that collided try again in level 1 (smaller,
+ * with a different hash) and so on. An id's slot is the number of set bits
+ * before its own, counted from a running total kept every 512 bits. With
+ * levels as big as the ids they get (gamma 1) that's about 3 bits per bid,
+ * plus 32 for the row.
+ *
+ * That's the trade-off against the chained table: a lookup checks one bit per
+ * level until it finds its id's bit, which is one cache miss per level (2.7 on
+ * average for the monthly file, 15 levels at most), and the 32 bit row is
+ * there on top of the bid because the slot order isn't the file's. build(2)
+ * halves the levels (1.65 checks on average) for 0.6 more bits per bid.
+ *
+ * The whole index is one array of 64 bit words laid out like the .mph file
+ * saved next to the CSV, so opening it again is just mapping that file.
+ */
+class PerfectHashTable {
+
+private:
+    static const uint64_t MAGIC = 0x31304850'4d444942ull; // "BIDMPH01"
+    static const size_t HEADER_WORDS = 5;                  // magic, rows, ids, levels, bit words
+    static const unsigned int MAX_LEVELS = 64;
+
+    csv::Table records;                  // the bids themselves
+    vector<uint64_t> built;              // the index, if it was built here
+    unique_ptr<csv::MappedFile> mapped;  // or the .mph file it was read from
+
+    // views into built or mapped
+    size_t indexWords = 0;
+    size_t keyCount = 0;
+    unsigned int levelCount = 0;
+    const uint64_t* levelStart = nullptr; // levelCount + 1 offsets into bits, in words
+    const uint64_t* bits = nullptr;
+    const uint32_t* ranks = nullptr;      // set bits before each 512 bit block
+    const uint32_t* rows = nullptr;       // slot -> row in records
+
+    static uint64_t levelHash(uint64_t h, unsigned int level);
+    static size_t rankWords(size_t bitWords) { return ((bitWords + 7) / 8 + 1) / 2; } // one 32 bit rank per 8 words
+    static size_t layoutWords(size_t keys, unsigned int levels, size_t bitWords);
+    bool attach(const uint64_t* data, size_t words);
+    size_t slotOf(uint64_t h) const;
+
+public:
+    static const size_t NOT_FOUND = SIZE_MAX;
+
+    explicit PerfectHashTable(csv::Table table);
+    static unique_ptr<PerfectHashTable> open(const string& csvPath);
+    void build(double gamma = 1.0);
+    bool load(const string& indexPath);
+    void save(const string& indexPath) const;
+    bool Find(string_view bidId, Bid& bid) const;
+    size_t size() const { return keyCount; }
+    size_t bytes() const;
+    double bitsPerKey() const;
+    bool fromFile() const { return mapped != nullptr; }
+};
+
+/**
+ * Take over the bids. There's no index until build() or load().
+ */
+PerfectHashTable::PerfectHashTable(csv::Table table) : records(std::move(table)) {
+}
+
+/**
+ * Load the bids of a CSV file (through its snapshot) and their index: mapped
+ * from the .mph file next to the CSV if it's newer than the CSV and still fits,
+ * otherwise built and saved there for next time.
+ *
+ * @param csvPath the path to the CSV file
+ * @return the table, csv::Error gets thrown if the CSV can't be read
+ */
+unique_ptr<PerfectHashTable> PerfectHashTable::open(const string& csvPath) {
+    unique_ptr<PerfectHashTable> table(new PerfectHashTable(csv::Table::open(csvPath, BID_COLUMNS)));
+    string indexPath = csvPath + ".mph";
+
+    error_code ec;
+    filesystem::file_time_type csvTime = filesystem::last_write_time(csvPath, ec);
+    if (!ec) {
+        filesystem::file_time_type indexTime = filesystem::last_write_time(indexPath, ec);
+        if (!ec && indexTime > csvTime && table->load(indexPath)) {
+            return table;
+        }
+    }
+
+    table->build();
+    try {
+        table->save(indexPath);
+    } catch (csv::Error&) {
+        // a read-only folder just means building it again next time
+    }
+    return table;
+}
+
+// a different hash of the id for every level
+uint64_t PerfectHashTable::levelHash(uint64_t h, unsigned int level) {
+    return mum(h ^ 0xa0761d6478bd642full, (level * 2 + 1) * 0xe7037ed1a0b428dbull);
+}
+
+// size of the index in words: header, level offsets, bits, ranks and rows (32 bit ones packed two per word)
+size_t PerfectHashTable::layoutWords(size_t keys, unsigned int levels, size_t bitWords) {
+    return HEADER_WORDS + (levels + 1) + bitWords + rankWords(bitWords) + (keys + 1) / 2;
+}
+
+/**
+ * Build the index over the bid ids. When an id is in the file more than once
+ * the first row gets it, same as Search on the chained table.
+ *
+ * @param gamma bits per id in each level, more makes building and lookups
+ *              a bit faster (fewer levels) for more memory
+ */
+void PerfectHashTable::build(double gamma) {
+    // (hash, row) of every distinct id, sorted so duplicates end up next to each other
+    vector<pair<uint64_t, uint32_t>> keys(records.rowCount());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = {hashKey(records.str(0, i), eWYHASH), static_cast<uint32_t>(i)};
+    }
+    sort(keys.begin(), keys.end());
+    size_t distinct = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (distinct > 0 && keys[distinct - 1].first == keys[i].first) {
+            if (records.str(0, keys[distinct - 1].second) != records.str(0, keys[i].second)) {
+                // two different ids, same 64 bit hash, no level could ever split them up
+                throw csv::Error("bid ids " + string(records.str(0, keys[i].second)) + " and " +
+                                 string(records.str(0, keys[distinct - 1].second)) + " have the same hash");
+            }
+            continue;
+        }
+        keys[distinct++] = keys[i];
+    }
+    keys.resize(distinct);
+
+    // lay the levels down one after the other
+    vector<uint64_t> levelWords, starts(1, 0);
+    vector<uint64_t> remaining(keys.size()), seen, collided;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        remaining[i] = keys[i].first;
+    }
+    for (unsigned int level = 0; !remaining.empty(); ++level) {
+        if (level == MAX_LEVELS) {
+            throw csv::Error("perfect hash didn't converge");
+        }
+        size_t words = max<size_t>(1, (static_cast<size_t>(remaining.size() * gamma) + 63) / 64);
+        uint64_t size = words * 64;
+        seen.assign(words, 0);
+        collided.assign(words, 0);
+        for (uint64_t h : remaining) {
+            uint64_t pos = ((levelHash(h, level) >> 32) * size) >> 32;
+            uint64_t mask = uint64_t(1) << (pos % 64);
+            collided[pos / 64] |= seen[pos / 64] & mask;
+            seen[pos / 64] |= mask;
+        }
+
+        // the ones that had their bit to themselves are done, the rest go to the next level
+        size_t kept = 0;
+        for (uint64_t h : remaining) {
+            uint64_t pos = ((levelHash(h, level) >> 32) * size) >> 32;
+            if (collided[pos / 64] & (uint64_t(1) << (pos % 64))) {
+                remaining[kept++] = h;
+            }
+        }
+        remaining.resize(kept);
+        for (size_t w = 0; w < words; ++w) {
+            levelWords.push_back(seen[w] & ~collided[w]);
+        }
+        starts.push_back(levelWords.size());
+    }
+
+    // write out the layout, then point the views at it
+    built.assign(layoutWords(keys.size(), starts.size() - 1, levelWords.size()), 0);
+    built[0] = MAGIC;
+    built[1] = records.rowCount();
+    built[2] = keys.size();
+    built[3] = starts.size() - 1;
+    built[4] = levelWords.size();
+    copy(starts.begin(), starts.end(), built.begin() + HEADER_WORDS);
+    copy(levelWords.begin(), levelWords.end(), built.begin() + HEADER_WORDS + starts.size());
+    uint32_t* rankOut = reinterpret_cast<uint32_t*>(built.data() + HEADER_WORDS + starts.size() + levelWords.size());
+    uint32_t* rowOut = reinterpret_cast<uint32_t*>(built.data() + HEADER_WORDS + starts.size() + levelWords.size() +
+                                                   rankWords(levelWords.size()));
+    uint32_t total = 0;
+    for (size_t w = 0; w < levelWords.size(); ++w) {
+        if (w % 8 == 0) {
+            rankOut[w / 8] = total;
+        }
+        total += popcount(levelWords[w]);
+    }
+    mapped.reset();
+    if (!attach(built.data(), built.size())) {
+        // same check open() relies on for a .mph file, a layout that fails it here is a bug in build
+        built.clear();
+        indexWords = keyCount = levelCount = 0; // the old views went with mapped
+        throw csv::Error("perfect hash index didn't check out after building it");
+    }
+
+    // every id's slot is only known now that the ranks are there
+    for (const pair<uint64_t, uint32_t>& key : keys) {
+        rowOut[slotOf(key.first)] = key.second;
+    }
+}
+
+/**
+ * Use an index file instead of building one
+ *
+ * @param indexPath the .mph file
+ * @return false if it can't be read, or is for some other set of bids
+ */
+bool PerfectHashTable::load(const string& indexPath) {
+    unique_ptr<csv::MappedFile> file;
+    try {
+        file.reset(new csv::MappedFile(indexPath));
+    } catch (csv::Error&) {
+        return false;
+    }
+    if (file->size() % 8 != 0 || !attach(reinterpret_cast<const uint64_t*>(file->data()), file->size() / 8)) {
+        return false;
+    }
+    mapped = std::move(file);
+    built.clear();
+    return true;
+}
+
+// check the header and point the views into data, false (and no views) if it doesn't add up
+bool PerfectHashTable::attach(const uint64_t* data, size_t words) {
+    if (words < HEADER_WORDS || data[0] != MAGIC || data[1] != records.rowCount() || data[2] > data[1] ||
+        data[3] > MAX_LEVELS || data[4] > words) {
+        return false;
+    }
+    size_t bitWords = data[4];
+    if (layoutWords(data[2], data[3], bitWords) != words) {
+        return false;
+    }
+    const uint64_t* starts = data + HEADER_WORDS;
+    for (unsigned int level = 0; level < data[3]; ++level) {
+        if (starts[level] >= starts[level + 1]) {
+            return false;
+        }
+    }
+    if (starts[0] != 0 || starts[data[3]] != bitWords) {
+        return false;
+    }
+    // slotOf trusts the ranks and Find trusts the rows, so a stale or damaged file must not get
+    // that far: every rank has to be the number of bits before its block (so no slot gets past
+    // the number of ids), and every row has to be one of the snapshot's rows
+    const uint64_t* bitsIn = starts + data[3] + 1;
+    const uint32_t* ranksIn = reinterpret_cast<const uint32_t*>(bitsIn + bitWords);
+    const uint32_t* rowsIn = reinterpret_cast<const uint32_t*>(bitsIn + bitWords + rankWords(bitWords));
+    uint64_t total = 0;
+    for (size_t w = 0; w < bitWords; ++w) {
+        if (w % 8 == 0 && ranksIn[w / 8] != total) {
+            return false;
+        }
+        total += popcount(bitsIn[w]);
+    }
+    if (total != data[2]) {
+        return false;
+    }
+    for (size_t i = 0; i < data[2]; ++i) {
+        if (rowsIn[i] >= records.rowCount()) {
+            return false;
+        }
+    }
+
+    levelStart = starts;
+    bits = bitsIn;
+    ranks = ranksIn;
+    rows = rowsIn;
+    indexWords = words;
+    keyCount = data[2];
+    levelCount = data[3];
+    return true;
+}
+
+// the id's slot, or NOT_FOUND if it didn't get a bit in any level (so it definitely isn't a bid)
+size_t PerfectHashTable::slotOf(uint64_t h) const {
+    for (unsigned int level = 0; level < levelCount; ++level) {
+        uint64_t size = (levelStart[level + 1] - levelStart[level]) * 64;
+        uint64_t pos = levelStart[level] * 64 + (((levelHash(h, level) >> 32) * size) >> 32);
+        if (bits[pos / 64] & (uint64_t(1) << (pos % 64))) {
+            size_t slot = ranks[pos / 512];
+            for (size_t w = pos / 512 * 8; w < pos / 64; ++w) {
+                slot += popcount(bits[w]);
+            }
+            return slot + popcount(bits[pos / 64] & ((uint64_t(1) << (pos % 64)) - 1));
+        }
+    }
+    return NOT_FOUND;
+}
+
+/**
+ * Write the index, to a temp file that then gets renamed over indexPath
+ */
+void PerfectHashTable::save(const string& indexPath) const {
+    const char* data = mapped ? mapped->data() : reinterpret_cast<const char*>(built.data());
+    replaceFile(indexPath, string_view(data, bytes()));
+}
+
+/**
+ * Search for a bid
+ *
+ * @param bidId The bid id to search for
+ * @param bid gets a copy of the bid if it's there
+ * @return true if it was found
+ */
+bool PerfectHashTable::Find(string_view bidId, Bid& bid) const {
+    size_t slot = slotOf(hashKey(bidId, eWYHASH));
+    if (slot == NOT_FOUND || rows[slot] >= records.rowCount() || records.str(0, rows[slot]) != bidId) {
+        return false;
+    }
+    size_t row = rows[slot];
+    bid.bidId = bidId;
+    bid.title = records.str(1, row);
+    bid.fund = records.str(2, row);
+    bid.amount = records.doubles(3)[row];
+    return true;
+}
+
+// size of the whole index (the bids themselves not included)
+size_t PerfectHashTable::bytes() const {
+    return indexWords * 8;
+}
+
+// size of just the hash function (levels and ranks) per bid, the rows are another 32 bits each
+double PerfectHashTable::bitsPerKey() const {
+    if (keyCount == 0) {
+        return 0;
+    }
+    size_t bitWords = levelStart[levelCount];
+    return (levelCount + 1 + bitWords + rankWords(bitWords)) * 64.0 / keyCount;
+}
+
+//============================================================================
+// DiskHashTable class definition
+//============================================================================
+
+/**
+ * Hash table that lives in two files and gets used straight out of them
+ *
+ * <path>.dat holds the bids one after another and <path>.idx is an open
+ * addressing table (linear probing) of {hash, where the bid is in .dat}. Both
+ * files are mapped read/write, so opening the table is two mmaps and a header
+ * check however many bids there are. Lookups read the mapped pages, Insert
+ * and Remove write to them, and the OS puts the changes back in the files.
+ * A new bid is flushed to .dat before the index is changed to point at it.
+ *
+ * Bids only ever get appended to .dat: a repeated id gets a slot of its own,
+ * further along the probe sequence than the ones already there, and Remove
+ * leaves a tombstone in the index. compact() writes both files again with only the
+ * live bids. Growing the index and compacting build new files next to the
+ * old ones and rename them over, so the old pair stays usable until then.
+ */
+class DiskHashTable : public BidTable {
+
+private:
+    static constexpr uint64_t INDEX_MAGIC = 0x31305844'49444942ull; // "BIDIDX01"
+    static constexpr uint64_t DATA_MAGIC = 0x31305441'44444942ull;  // "BIDDAT01"
+    static constexpr uint64_t EMPTY = 0;     // slot offsets, real ones are past the .dat header
+    static constexpr uint64_t TOMBSTONE = 1;
+    static constexpr size_t MIN_SLOTS = 256;
+
+    struct IndexHeader {
+        uint64_t magic;
+        uint64_t generation; // has to match the .dat's, compact() moves both on
+        uint64_t slots;      // a power of two
+        uint64_t count;      // live bids
+        uint64_t used;       // slots with a bid or a tombstone
+        uint64_t dataSize;   // bytes of .dat in use, the rest is room to append
+        uint64_t unused[2];
+    };
+
+    struct DataHeader {
+        uint64_t magic;
+        uint64_t generation;
+    };
+
+    struct Slot {
+        uint64_t hash;
+        uint64_t offset;
+    };
+
+    // a bid in .dat: this, then the id, title and fund characters, padded to 8 bytes
+    struct Record {
+        uint32_t idSize;
+        uint32_t titleSize;
+        uint32_t fundSize;
+        uint32_t unused;
+        double amount;
+    };
+
+    // a file mapped read/write (the system headers come in with CSVparser.cpp)
+    struct Mapping {
+        string path;
+        char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE view = nullptr;
+#else
+        int fd = -1;
+#endif
+
+        Mapping() = default;
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+        ~Mapping() { close(); }
+        void open(const string& file);
+        void resize(size_t newSize);
+        void flush(size_t from, size_t bytes);
+        void close();
+
+    private:
+        void map();
+        void unmap();
+    };
+
+    Mapping index, data;
+
+    IndexHeader& header() const { return *reinterpret_cast<IndexHeader*>(index.data); }
+    Slot* slots() const { return reinterpret_cast<Slot*>(index.data + sizeof(IndexHeader)); }
+    static size_t slotsFor(size_t n);
+    static size_t recordSize(const Record* record);
+    static string_view recordId(const Record* record);
+    static Bid recordBid(const Record* record);
+    const Record* recordAt(uint64_t offset) const;
+    size_t findSlot(string_view bidId, uint64_t h) const;
+    size_t walkStart() const;
+    uint64_t append(const Bid& bid);
+    void rebuildIndex(size_t newSlots);
+    void indexFromData();
+    void reopen();
+
+public:
+    explicit DiskHashTable(const string& path);
+    virtual ~DiskHashTable();
+    void Insert(Bid bid) override;
+    void PrintAll() override;
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void reserve(size_t n) override;
+    size_t size() const override;
+    bool Find(string_view bidId, Bid& bid) const;
+    bool Erase(string_view bidId);
+    void compact();
+    size_t capacity() const { return header().slots; }
+    size_t dataBytes() const { return header().dataSize; }
+    bool isOpen() const { return index.data != nullptr && data.data != nullptr; } // false after compact() couldn't open it again
+};
+
+#ifdef _WIN32
+void DiskHashTable::Mapping::open(const string& file) {
+    path = file;
+    this->file = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        throw csv::Error("Failed to open " + file);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize)) {
+        close();
+        throw csv::Error("Failed to read size of " + file);
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    map();
+}
+
+void DiskHashTable::Mapping::resize(size_t newSize) {
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(newSize);
+    if (newSize >= size) {
+        // a mapping bigger than the file grows the file, and the old view stays until the new one is there
+        HANDLE newView = CreateFileMappingA(file, nullptr, PAGE_READWRITE, end.HighPart, end.LowPart, nullptr);
+        char* p = newView != nullptr ? static_cast<char*>(MapViewOfFile(newView, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+        if (p == nullptr) {
+            if (newView != nullptr) {
+                CloseHandle(newView);
+            }
+            throw csv::Error("Failed to resize " + path);
+        }
+        unmap();
+        view = newView;
+        data = p;
+        size = newSize;
+        return;
+    }
+
+    // Windows won't cut a file that's mapped, so shrinking has to unmap first. If it
+    // can't be mapped again after that, data stays nullptr and isOpen() says so
+    unmap();
+    bool cut = SetFilePointerEx(file, end, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+    if (cut) {
+        size = newSize;
+    }
+    map();
+    if (!cut) {
+        throw csv::Error("Failed to resize " + path);
+    }
+}
+
+// write a range of the mapping back to the file and wait for the disk to have it
+void DiskHashTable::Mapping::flush(size_t from, size_t bytes) {
+    if (!FlushViewOfFile(data + from, bytes) || !FlushFileBuffers(file)) {
+        throw csv::Error("Failed to flush " + path);
+    }
+}
+
+void DiskHashTable::Mapping::close() {
+    unmap();
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+}
+
+void DiskHashTable::Mapping::map() {
+    if (size == 0) {
+        return;
+    }
+    view = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (view != nullptr) {
+        data = static_cast<char*>(MapViewOfFile(view, FILE_MAP_WRITE, 0, 0, 0));
+    }
+    if (data == nullptr) {
+        throw csv::Error("Failed to map " + path);
+    }
+}
+
+void DiskHashTable::Mapping::unmap() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (view != nullptr) {
+        CloseHandle(view);
+        view = nullptr;
+    }
+}
+#else
+void DiskHashTable::Mapping::open(const string& file) {
+    path = file;
+    fd = ::open(file.c_str(), O_RDWR);
+    if (fd < 0) {
+        throw csv::Error("Failed to open " + file);
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        close();
+        throw csv::Error("Failed to read size of " + file);
+    }
+    size = static_cast<size_t>(st.st_size);
+    map();
+}
+
+void DiskHashTable::Mapping::resize(size_t newSize) {
+    // the old mapping stays until the new one is there, so a failure leaves this as it was
+    // (the file may be left longer than size, which is only room to append into)
+    if (::ftruncate(fd, static_cast<off_t>(newSize)) != 0) {
+        throw csv::Error("Failed to resize " + path);
+    }
+    void* p = nullptr;
+    if (newSize > 0) {
+        p = ::mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            throw csv::Error("Failed to map " + path);
+        }
+    }
+    unmap();
+    data = static_cast<char*>(p);
+    size = newSize;
+}
+
+// write a range of the mapping back to the file and wait for the disk to have it
+void DiskHashTable::Mapping::flush(size_t from, size_t bytes) {
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t start = from / page * page; // msync wants a page aligned address
+    if (::msync(data + start, from + bytes - start, MS_SYNC) != 0) {
+        throw csv::Error("Failed to flush " + path);
+    }
+}
+
+void DiskHashTable::Mapping::close() {
+    unmap();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void DiskHashTable::Mapping::map() {
+    if (size == 0) {
+        return;
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        throw csv::Error("Failed to map " + path);
+    }
+    data = static_cast<char*>(p);
+}
+
+void DiskHashTable::Mapping::unmap() {
+    if (data != nullptr) {
+        ::munmap(data, size);
+        data = nullptr;
+    }
+}
+#endif
+
+/**
+ * Open the table in <path>.idx and <path>.dat, or start an empty one there if
+ * neither file exists yet
+ *
+ * @param path where the files go, without the extensions
+ */
+DiskHashTable::DiskHashTable(const string& path) {
+    index.path = path + ".idx";
+    data.path = path + ".dat";
+    bool haveIndex = filesystem::exists(index.path), haveData = filesystem::exists(data.path);
+    if (haveIndex != haveData) {
+        throw csv::Error("Only one of " + index.path + " and " + data.path + " is there");
+    }
+    if (!haveIndex) {
+        DataHeader dataHeader = {DATA_MAGIC, 1};
+        replaceFile(data.path, string_view(reinterpret_cast<const char*>(&dataHeader), sizeof(dataHeader)));
+        string out(sizeof(IndexHeader) + MIN_SLOTS * sizeof(Slot), '\0');
+        IndexHeader indexHeader = {INDEX_MAGIC, 1, MIN_SLOTS, 0, 0, sizeof(DataHeader), {0, 0}};
+        memcpy(out.data(), &indexHeader, sizeof(indexHeader));
+        replaceFile(index.path, out);
+    }
+    reopen();
+}
+
+// map both files again and make sure they're a matching pair
+void DiskHashTable::reopen() {
+    index.open(index.path);
+    data.open(data.path);
+    bool ok = index.size >= sizeof(IndexHeader) && data.size >= sizeof(DataHeader);
+    if (ok) {
+        // compact() writes the .dat first, so if it got stopped before the .idx, the .idx is from
+        // the generation before. The new .dat holds just the live bids, so build the index again from it
+        const DataHeader& dataHead = *reinterpret_cast<const DataHeader*>(data.data);
+        if (header().magic == INDEX_MAGIC && dataHead.magic == DATA_MAGIC && header().generation < dataHead.generation) {
+            indexFromData();
+        }
+    }
+    if (ok) {
+        const IndexHeader& head = header();
+        const DataHeader& dataHead = *reinterpret_cast<const DataHeader*>(data.data);
+        ok = head.magic == INDEX_MAGIC && dataHead.magic == DATA_MAGIC && head.generation == dataHead.generation &&
+             has_single_bit(head.slots) && head.used < head.slots && head.count <= head.used &&
+             index.size >= sizeof(IndexHeader) + head.slots * sizeof(Slot) &&
+             head.dataSize >= sizeof(DataHeader) && head.dataSize <= data.size;
+    }
+    if (!ok) {
+        index.close();
+        data.close();
+        throw csv::Error(index.path + " and " + data.path + " aren't a matching bid table");
+    }
+}
+
+/**
+ * Destructor, gives back the room kept at the end of .dat for appending
+ */
+DiskHashTable::~DiskHashTable() {
+    try {
+        if (data.data != nullptr && index.data != nullptr) {
+            data.resize(header().dataSize);
+        }
+    } catch (csv::Error&) {
+        // it only costs some disk space
+    }
+}
+
+// smallest power of two (at least MIN_SLOTS) that keeps n bids under 3/4 full
+size_t DiskHashTable::slotsFor(size_t n) {
+    size_t slots = MIN_SLOTS;
+    while (n > slots / 4 * 3) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+size_t DiskHashTable::recordSize(const Record* record) {
+    size_t bytes = sizeof(Record) + record->idSize + record->titleSize + record->fundSize;
+    return (bytes + 7) & ~size_t(7);
+}
+
+string_view DiskHashTable::recordId(const Record* record) {
+    return string_view(reinterpret_cast<const char*>(record + 1), record->idSize);
+}
+
+Bid DiskHashTable::recordBid(const Record* record) {
+    const char* text = reinterpret_cast<const char*>(record + 1);
+    Bid bid;
+    bid.bidId.assign(text, record->idSize);
+    bid.title.assign(text + record->idSize, record->titleSize);
+    bid.fund.assign(text + record->idSize + record->titleSize, record->fundSize);
+    bid.amount = record->amount;
+    return bid;
+}
+
+// the record at offset in .dat, or nullptr if it doesn't fit in the part that's in use
+const DiskHashTable::Record* DiskHashTable::recordAt(uint64_t offset) const {
+    uint64_t end = header().dataSize;
+    if (offset < sizeof(DataHeader) || offset % 8 != 0 || offset + sizeof(Record) > end) {
+        return nullptr;
+    }
+    const Record* record = reinterpret_cast<const Record*>(data.data + offset);
+    if (offset + recordSize(record) > end) {
+        return nullptr;
+    }
+    return record;
+}
+
+// the slot holding bidId, or SIZE_MAX
+size_t DiskHashTable::findSlot(string_view bidId, uint64_t h) const {
+    const Slot* table = slots();
+    size_t mask = header().slots - 1;
+    for (size_t i = h & mask; table[i].offset != EMPTY; i = (i + 1) & mask) {
+        if (table[i].offset != TOMBSTONE && table[i].hash == h) {
+            const Record* record = recordAt(table[i].offset);
+            if (record != nullptr && recordId(record) == bidId) {
+                return i;
+            }
+        }
+    }
+    return SIZE_MAX;
+}
+
+// write the bid at the end of .dat (growing the file by doubling) and return where it went.
+// The record is on the disk before dataSize in the .idx says it's there, otherwise the .idx
+// pages could get written back first and a crash would leave it pointing at garbage
+uint64_t DiskHashTable::append(const Bid& bid) {
+    Record record = {static_cast<uint32_t>(bid.bidId.size()), static_cast<uint32_t>(bid.title.size()),
+                     static_cast<uint32_t>(bid.fund.size()), 0, bid.amount};
+    uint64_t offset = header().dataSize;
+    size_t bytes = recordSize(&record);
+    if (offset + bytes > data.size) {
+        data.resize(max(data.size * 2, offset + bytes));
+    }
+    char* out = data.data + offset;
+    memcpy(out, &record, sizeof(record));
+    out += sizeof(record);
+    memcpy(out, bid.bidId.data(), bid.bidId.size());
+    memcpy(out + bid.bidId.size(), bid.title.data(), bid.title.size());
+    memcpy(out + bid.bidId.size() + bid.title.size(), bid.fund.data(), bid.fund.size());
+    data.flush(offset, bytes);
+    header().dataSize = offset + bytes;
+    return offset;
+}
+
+// the slot right after an empty one. Going round the table from there visits every
+// probe sequence from its start, so bids with the same id come up in the order they went in
+size_t DiskHashTable::walkStart() const {
+    const Slot* table = slots();
+    size_t i = 0;
+    while (table[i].offset != EMPTY) { // there's always one, the table is never more than 3/4 used
+        ++i;
+    }
+    return i + 1;
+}
+
+// write a new .idx with newSlots slots and no tombstones, and switch to it
+void DiskHashTable::rebuildIndex(size_t newSlots) {
+    string out(sizeof(IndexHeader) + newSlots * sizeof(Slot), '\0');
+    IndexHeader head = header();
+    head.slots = newSlots;
+    head.used = head.count;
+    memcpy(out.data(), &head, sizeof(head));
+
+    Slot* table = reinterpret_cast<Slot*>(out.data() + sizeof(IndexHeader));
+    const Slot* old = slots();
+    size_t oldMask = header().slots - 1;
+    for (size_t k = 0, i = walkStart() & oldMask; k < header().slots; ++k, i = (i + 1) & oldMask) {
+        if (old[i].offset > TOMBSTONE) {
+            size_t j = old[i].hash & (newSlots - 1);
+            while (table[j].offset != EMPTY) {
+                j = (j + 1) & (newSlots - 1);
+            }
+            table[j] = old[i];
+        }
+    }
+
+    index.close();
+    try {
+        replaceFile(index.path, out);
+    } catch (csv::Error&) {
+        index.open(index.path); // keep going with the old one
+        throw;
+    }
+    index.open(index.path);
+}
+
+// write a new .idx for every record in .dat, for when the .idx on disk is older than the .dat.
+// The records run up to the end of the file (compact() writes it with no room left over),
+// in the order they went in, so a repeated id's slots end up in that order too
+void DiskHashTable::indexFromData() {
+    vector<Slot> found;
+    size_t end = sizeof(DataHeader);
+    while (end + sizeof(Record) <= data.size) {
+        const Record* record = reinterpret_cast<const Record*>(data.data + end);
+        if (record->idSize == 0 || end + recordSize(record) > data.size) {
+            break;
+        }
+        found.push_back({hashKey(recordId(record), eWYHASH), end});
+        end += recordSize(record);
+    }
+
+    size_t newSlots = slotsFor(found.size());
+    string out(sizeof(IndexHeader) + newSlots * sizeof(Slot), '\0');
+    Slot* table = reinterpret_cast<Slot*>(out.data() + sizeof(IndexHeader));
+    size_t count = found.size();
+    for (const Slot& slot : found) {
+        size_t j = slot.hash & (newSlots - 1);
+        while (table[j].offset != EMPTY) {
+            j = (j + 1) & (newSlots - 1);
+        }
+        table[j] = slot;
+    }
+    uint64_t generation = reinterpret_cast<const DataHeader*>(data.data)->generation;
+    IndexHeader head = {INDEX_MAGIC, generation, newSlots, count, count, end, {0, 0}};
+    memcpy(out.data(), &head, sizeof(head));
+
+    index.close();
+    replaceFile(index.path, out);
+    index.open(index.path);
+}
+
+/**
+ * Insert a bid, after any bids with the same id
+ *
+ * @param bid The bid to insert
+ */
+void DiskHashTable::Insert(Bid bid) {
+    // keep at most 3/4 of the slots taken, and rebuild at the same size if it's mostly tombstones
+    if (header().used + 1 > header().slots / 4 * 3) {
+        rebuildIndex(header().count + 1 > header().slots / 2 ? header().slots * 2 : header().slots);
+    }
+
+    uint64_t h = hashKey(bid.bidId, eWYHASH);
+    uint64_t offset = append(bid);
+
+    IndexHeader& head = header();
+    Slot* table = slots();
+    size_t mask = head.slots - 1;
+    size_t target = SIZE_MAX;
+    size_t i = h & mask;
+    for (; table[i].offset != EMPTY; i = (i + 1) & mask) {
+        if (table[i].offset == TOMBSTONE) {
+            if (target == SIZE_MAX) {
+                target = i;
+            }
+        } else if (table[i].hash == h) {
+            const Record* record = recordAt(table[i].offset);
+            if (record != nullptr && recordId(record) == bid.bidId) {
+                target = SIZE_MAX; // a tombstone before a bid with this id would put the new one first
+            }
+        }
+    }
+    if (target == SIZE_MAX) {
+        target = i;
+        ++head.used;
+    }
+    table[target].hash = h;
+    table[target].offset = offset;
+    ++head.count;
+}
+
+/**
+ * Print all bids
+ */
+void DiskHashTable::PrintAll() {
+    const Slot* table = slots();
+    for (size_t i = 0; i < header().slots; ++i) {
+        const Record* record = table[i].offset > TOMBSTONE ? recordAt(table[i].offset) : nullptr;
+        if (record != nullptr) {
+            cout << "Key: " << i << ";  ";
+            cout << "Bid ID: ";
+            displayBid(recordBid(record));
+        }
+    }
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to search for
+ */
+void DiskHashTable::Remove(string bidId) {
+    if (Erase(bidId)) {
+        cout << "Successfully removed bid ID# " << bidId << endl;
+    } else {
+        cout << "Bid with ID# " << bidId << " not found in hash table." << endl;
+    }
+}
+
+/**
+ * Remove a bid without printing anything
+ *
+ * @param bidId The bid id to remove
+ * @return true if it was there
+ */
+bool DiskHashTable::Erase(string_view bidId) {
+    // only the .idx changes here, whatever Insert put in .dat was flushed before its slot was set
+    size_t slot = findSlot(bidId, hashKey(bidId, eWYHASH));
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+    IndexHeader& head = header();
+    Slot* table = slots();
+    // a tombstone is only needed if some probe could run on past this slot
+    if (table[(slot + 1) & (head.slots - 1)].offset == EMPTY) {
+        table[slot].offset = EMPTY;
+        --head.used;
+    } else {
+        table[slot].offset = TOMBSTONE;
+    }
+    --head.count;
+    return true;
+}
+
+/**
+ * Search for a bid
+ *
+ * @param bidId The bid id to search for
+ */
+Bid DiskHashTable::Search(string bidId) {
+    Bid bid;
+    if (Find(bidId, bid)) {
+        cout << "Ladies and gentlemen, we got 'em... found bid ID# " << bidId << endl;
+    } else {
+        cout << "Error: bid ID# " << bidId << " not found." << endl;
+    }
+    return bid;
+}
+
+/**
+ * Search for a bid without printing anything
+ *
+ * @param bidId The bid id to search for
+ * @param bid gets a copy of the bid if it's there
+ * @return true if it was found
+ */
+bool DiskHashTable::Find(string_view bidId, Bid& bid) const {
+    size_t slot = findSlot(bidId, hashKey(bidId, eWYHASH));
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+    bid = recordBid(recordAt(slots()[slot].offset));
+    return true;
+}
+
+/**
+ * Make room in the index for n bids, so loading doesn't keep rebuilding it
+ */
+void DiskHashTable::reserve(size_t n) {
+    if (slotsFor(n) > header().slots) {
+        rebuildIndex(slotsFor(n));
+    }
+}
+
+size_t DiskHashTable::size() const {
+    return header().count;
+}
+
+/**
+ * Write both files again with only the live bids, dropping old versions and
+ * removed bids from .dat and tombstones from .idx
+ */
+void DiskHashTable::compact() {
+    const IndexHeader& old = header();
+    uint64_t generation = old.generation + 1;
+    size_t newSlots = slotsFor(old.count);
+
+    DataHeader dataHeader = {DATA_MAGIC, generation};
+    string dat(reinterpret_cast<const char*>(&dataHeader), sizeof(dataHeader));
+    string idx(sizeof(IndexHeader) + newSlots * sizeof(Slot), '\0');
+    Slot* table = reinterpret_cast<Slot*>(idx.data() + sizeof(IndexHeader));
+    const Slot* oldTable = slots();
+    for (size_t k = 0, i = walkStart() & (old.slots - 1); k < old.slots; ++k, i = (i + 1) & (old.slots - 1)) {
+        const Record* record = oldTable[i].offset > TOMBSTONE ? recordAt(oldTable[i].offset) : nullptr;
+        if (record == nullptr) {
+            continue;
+        }
+        size_t j = oldTable[i].hash & (newSlots - 1);
+        while (table[j].offset != EMPTY) {
+            j = (j + 1) & (newSlots - 1);
+        }
+        table[j].hash = oldTable[i].hash;
+        table[j].offset = dat.size();
+        dat.append(reinterpret_cast<const char*>(record), recordSize(record));
+    }
+    IndexHeader head = {INDEX_MAGIC, generation, newSlots, old.count, old.count, dat.size(), {0, 0}};
+    memcpy(idx.data(), &head, sizeof(head));
+
+    // .dat goes first: if something stops us in between, the generations don't match and
+    // reopen() builds the index again from the new .dat, rather than the old index pointing into it.
+    // The old files stay mapped until both new ones are in place, so if the .dat can't be
+    // replaced nothing has changed (Windows won't rename over a mapped file, so there they can't)
+#ifdef _WIN32
+    index.close();
+    data.close();
+#endif
+    bool dataReplaced = false;
+    try {
+        replaceFile(data.path, dat);
+        dataReplaced = true;
+        replaceFile(index.path, idx);
+    } catch (csv::Error&) {
+        if (dataReplaced || !isOpen()) {
+            // if this throws too, the table is closed and isOpen() says so
+            index.close();
+            data.close();
+            reopen();
+        }
+        throw;
+    }
+    index.close();
+    data.close();
+    reopen();
+}
+
+//============================================================================
+// Static methods used for testing
+//============================================================================
+
+/**
+ * Display the bid information to the console (std::out)
+ *
+ * @param bid struct containing the bid info
+ */
+void displayBid(Bid bid) {
+    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
+         << bid.fund << endl;
+}
+
+/**
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return a container holding all the bids read
+ */
+void loadBids(string csvPath, BidTable* hashTable) {
+    cout << "Loading CSV file " << csvPath << endl;
+
+    try {
+        // initialize the CSV Parser using the given path
+        // only id, title, fund and winning bid get loaded (BID_COLUMNS). The file is streamed and
+        // each bid gets inserted as soon as its row is read, while the columns are kept for a binary
+        // snapshot next to the CSV, so loading the same file again skips the parsing
+        auto insert = [hashTable](const csv::Table& file, size_t i) {
+            // a snapshot knows how many rows there are up front, so the table only has to grow once
+            if (i == 0 && file.fromSnapshot()) {
+                hashTable->reserve(hashTable->size() + file.rowCount());
+            }
+
+            // Create a data structure and add to the collection of bids
+            Bid bid;
+            bid.bidId = file.str(0, i);
+            bid.title = file.str(1, i);
+            bid.fund = file.str(2, i);
+            bid.amount = file.doubles(3)[i];
+
+            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+
+            // push this bid to the end
+            hashTable->Insert(bid);
+        };
+        csv::Table file = csv::Table::open(csvPath, BID_COLUMNS, ',', insert);
+        if (file.fromSnapshot()) {
+            cout << "Read from snapshot " << csvPath << ".snap" << endl;
+        }
+
+        // read and display header row - optional
+        for (unsigned int c = 0; c < file.columnCount(); c++) {
+            cout << file.name(c) << " | ";
+        }
+        cout << "" << endl;
+    } catch (csv::Error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/**
+ * Read the bids of a CSV file into a plain vector, for the benchmarks
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param bids gets the bids
+ * @return false (after saying why) if there's nothing to benchmark with
+ */
+bool readBids(const string& csvPath, vector<Bid>& bids) {
+    try {
+        csv::Table file = csv::Table::open(csvPath, BID_COLUMNS);
+        const double* amounts = file.doubles(3);
+        bids.resize(file.rowCount());
+        for (size_t i = 0; i < file.rowCount(); i++) {
+            bids[i].bidId = file.str(0, i);
+            bids[i].title = file.str(1, i);
+            bids[i].fund = file.str(2, i);
+            bids[i].amount = amounts[i];
+        }
+    } catch (csv::Error &e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+    if (bids.empty()) {
+        cout << "No bids in " << csvPath << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Time the CSV field scanner against the original parseContent loop
+ *
+ * Every line of the file is split 20 times with the old byte-at-a-time loop
+ * (at() + substr, like parseContent used to do) and then with csv::splitLine
+ * at every scan level this CPU supports. The field counts have to match.
+ *
+ * @param csvPath the path to the CSV file to scan
+ */
+void benchmarkScanner(const string& csvPath) {
+    const int passes = 20;
+
+    // read the lines up front so only the scanning gets timed
+    vector<string> lines;
+    size_t bytes = 0;
+    ifstream file(csvPath);
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty()) {
+            bytes += line.size();
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty()) {
+        cout << "No data in " << csvPath << endl;
+        return;
+    }
+    double megabytes = bytes * (double) passes / (1024.0 * 1024.0);
+
+    // the original loop
+    clock_t ticks = clock();
+    size_t legacyFields = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        for (auto it = lines.begin(); it != lines.end(); ++it) {
+            vector<string> values;
+            bool quoted = false;
+            int tokenStart = 0;
+            unsigned int i = 0;
+            for (; i != it->length(); i++) {
+                if (it->at(i) == '"')
+                    quoted = !(quoted);
+                else if (it->at(i) == ',' && !quoted) {
+                    values.push_back(it->substr(tokenStart, i - tokenStart));
+                    tokenStart = i + 1;
+                }
+            }
+            values.push_back(it->substr(tokenStart, it->length() - tokenStart));
+            legacyFields += values.size();
+        }
+    }
+    ticks = clock() - ticks;
+    double seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+    cout << "legacy loop: " << ticks << " clock ticks, " << megabytes / seconds << " MB/s" << endl;
+
+    const char* names[] = {"scalar", "SSE2", "AVX2"};
+    csv::ScanLevel previous = csv::getScanLevel();
+    vector<string_view> fields;
+    for (int level = csv::eSCALAR; level <= csv::detectScanLevel(); ++level) {
+        csv::setScanLevel(static_cast<csv::ScanLevel>(level));
+
+        ticks = clock();
+        size_t fieldCount = 0;
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const string& l : lines) {
+                fields.clear();
+                csv::splitLine(l, ',', fields);
+                fieldCount += fields.size();
+            }
+        }
+        ticks = clock() - ticks;
+        seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+        cout << names[level] << " splitLine: " << ticks << " clock ticks, " << megabytes / seconds << " MB/s";
+        if (fieldCount != legacyFields) {
+            cout << "  (field count mismatch: " << fieldCount << " vs " << legacyFields << ")";
+        }
+        cout << endl;
+    }
+    csv::setScanLevel(previous);
+}
+
+/**
+ * Compare the hash functions on the bids in a CSV file
+ *
+ * Every bid goes into a chained and an open addressing table built with each
+ * hash function, sized for the file up front so no table grows. For the chained
+ * tables it prints how many buckets hold lists of each length, for the open
+ * ones how far bids ended up from their home slot, and the average number of
+ * bids a successful lookup compares against.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkHashFunctions(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+    cout << bids.size() << " bids" << endl;
+
+    for (int f = eMODULO; f <= eFIBONACCI; ++f) {
+        HashFunction function = static_cast<HashFunction>(f);
+        cout << hashFunctionName(function) << ":" << endl;
+
+        HashTable chained(DEFAULT_SIZE, function);
+        chained.reserve(bids.size());
+        clock_t ticks = clock();
+        for (const Bid& bid : bids) {
+            chained.Insert(bid);
+        }
+        ticks = clock() - ticks;
+
+        // a lookup for the k-th bid of a list compares k bids
+        vector<size_t> lengths = chained.chainLengths();
+        size_t compares = 0;
+        for (size_t length = 1; length < lengths.size(); ++length) {
+            compares += lengths[length] * length * (length + 1) / 2;
+        }
+        cout << "  chained, " << chained.capacity() << " buckets, insert " << ticks << " clock ticks, "
+             << "avg compares " << (double) compares / bids.size() << endl;
+        cout << "    list length: buckets ";
+        for (size_t length = 0; length < lengths.size(); ++length) {
+            if (lengths[length] != 0) {
+                cout << " " << length << ":" << lengths[length];
+            }
+        }
+        cout << endl;
+
+        OpenHashTable open(bids.size(), function);
+        ticks = clock();
+        for (const Bid& bid : bids) {
+            open.Insert(bid);
+        }
+        ticks = clock() - ticks;
+
+        vector<size_t> probes = open.probeLengths();
+        compares = 0;
+        for (size_t i = 0; i < probes.size(); ++i) {
+            compares += probes[i] * (i + 1);
+        }
+        cout << "  open, " << open.capacity() << " slots, insert " << ticks << " clock ticks, "
+             << "avg probes " << (double) compares / open.size() << endl;
+        cout << "    probe length: bids ";
+        for (size_t i = 0; i < probes.size(); ++i) {
+            if (probes[i] != 0) {
+                cout << " " << i + 1 << ":" << probes[i];
+            }
+        }
+        cout << endl;
+    }
+}
+
+/**
+ * Read throughput of the ConcurrentHashTable from 1 thread up to all the cores
+ *
+ * All the bids get loaded, then for each thread count the readers look up
+ * random bids for half a second while one more thread keeps removing and
+ * re-inserting random bids (including growing the table now and then).
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkConcurrentReads(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+
+    ConcurrentHashTable table;
+    for (const Bid& bid : bids) {
+        table.Insert(bid);
+    }
+
+    unsigned int cores = max(1u, thread::hardware_concurrency());
+    cout << bids.size() << " bids, " << cores << " cores" << endl;
+
+    // 1, 2, 4, ... and then every core
+    vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    for (unsigned int threads : threadCounts) {
+        atomic<bool> stop{false};
+        atomic<size_t> reads{0}, hits{0};
+        size_t writes = 0;
+
+        vector<thread> readers;
+        for (unsigned int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t]() {
+                uint64_t x = 0x9e3779b97f4a7c15ull * (t + 1); // xorshift, rand() isn't thread safe
+                size_t myReads = 0, myHits = 0;
+                Bid bid;
+                while (!stop.load(memory_order_relaxed)) {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    myHits += table.Find(bids[x % bids.size()].bidId, bid);
+                    ++myReads;
+                }
+                reads += myReads;
+                hits += myHits;
+            });
+        }
+        thread writer([&]() {
+            uint64_t x = 88172645463325252ull;
+            while (!stop.load(memory_order_relaxed)) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                const Bid& bid = bids[x % bids.size()];
+                table.Erase(bid.bidId);
+                table.Insert(bid);
+                writes += 2;
+            }
+        });
+
+        this_thread::sleep_for(chrono::milliseconds(500));
+        stop = true;
+        for (thread& t : readers) {
+            t.join();
+        }
+        writer.join();
+
+        // counted over half a second, so times 2 for per second
+        cout << threads << " reader thread(s): " << reads * 2 / 1000000.0 << " M lookups/s ("
+             << reads * 2.0 / threads / 1000000.0 << " M per thread, " << (reads ? 100.0 * hits / reads : 0)
+             << "% found), " << writes * 2 / 1000000.0 << " M writes/s" << endl;
+    }
+}
+
+/**
+ * Lookup throughput of HashTable::SearchBatch for different batch sizes
+ *
+ * The bids from the file get copied (with "-1", "-2", ... added to the ids)
+ * until there are about a million, so the table is a lot bigger than the CPU
+ * caches, then a million random ids get looked up in batches of 1 (no
+ * overlap at all, like Search) up to 256.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkBatchLookup(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+
+    const size_t target = 1000000;
+    size_t copies = (target + bids.size() - 1) / bids.size();
+    HashTable table;
+    table.reserve(copies * bids.size());
+    vector<string> ids;
+    ids.reserve(copies * bids.size());
+    for (size_t c = 0; c < copies; ++c) {
+        for (Bid bid : bids) {
+            bid.bidId += "-" + to_string(c);
+            ids.push_back(bid.bidId);
+            table.Insert(bid);
+        }
+    }
+
+    vector<string_view> lookups(target);
+    uint64_t x = 88172645463325252ull;
+    for (string_view& id : lookups) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        id = ids[x % ids.size()];
+    }
+    cout << table.size() << " bids, " << lookups.size() << " random lookups" << endl;
+
+    vector<const Bid*> found(lookups.size());
+    for (size_t batch : {1, 4, 16, 64, 256}) {
+        clock_t ticks = clock();
+        size_t hits = 0;
+        for (size_t start = 0; start < lookups.size(); start += batch) {
+            size_t n = min(batch, lookups.size() - start);
+            hits += table.SearchBatch(span<const string_view>(lookups).subspan(start, n),
+                                      span<const Bid*>(found).subspan(start, n));
+        }
+        ticks = clock() - ticks;
+        double seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+        cout << "batch of " << batch << ": " << lookups.size() / seconds / 1000000.0 << " M lookups/s";
+        if (hits != lookups.size()) {
+            cout << "  (only " << hits << " found)";
+        }
+        cout << endl;
+    }
+}
+
+/**
+ * Time lookups for bids that aren't in the table, with and without the Bloom filter
+ *
+ * Same million-bid table as benchmarkBatchLookup, then a million ids that were
+ * never inserted (the real ids with "-x" added) get looked up with Find. Also
+ * checks how often the filter said "maybe" for them against what it estimates.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkBloomFilter(const string& csvPath) {
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+
+    const size_t target = 1000000;
+    size_t copies = (target + bids.size() - 1) / bids.size();
+    HashTable table;
+    table.reserve(copies * bids.size());
+    vector<string> missing;
+    missing.reserve(target);
+    for (size_t c = 0; c < copies; ++c) {
+        for (Bid bid : bids) {
+            bid.bidId += "-" + to_string(c);
+            if (missing.size() < target) {
+                missing.push_back(bid.bidId + "x");
+            }
+            table.Insert(bid);
+        }
+    }
+    cout << table.size() << " bids, " << missing.size() << " lookups for missing ids" << endl;
+
+    for (double bitsPerKey : {0.0, 6.0, 10.0, 16.0}) {
+        if (bitsPerKey == 0) {
+            table.disableFilter();
+        } else {
+            table.enableFilter(bitsPerKey);
+        }
+
+        clock_t ticks = clock();
+        size_t found = 0;
+        for (const string& id : missing) {
+            found += table.Find(id) != nullptr;
+        }
+        ticks = clock() - ticks;
+        double seconds = ticks * 1.0 / CLOCKS_PER_SEC;
+
+        if (bitsPerKey == 0) {
+            cout << "no filter: ";
+        } else {
+            cout << bitsPerKey << " bits/bid: ";
+        }
+        cout << missing.size() / seconds / 1000000.0 << " M lookups/s";
+        if (found != 0) {
+            cout << "  (" << found << " found?)";
+        }
+        const BloomFilter* filter = table.getFilter();
+        if (filter != nullptr) {
+            size_t maybes = 0;
+            for (const string& id : missing) {
+                maybes += filter->mayContainHash(hashKey(id, eWYHASH));
+            }
+            cout << ", false positives " << maybes * 100.0 / missing.size() << "% (estimated "
+                 << filter->falsePositiveRate() * 100.0 << "%), " << filter->bytes() / 1024 << " KB";
+        }
+        cout << endl;
+    }
+}
+
+/**
+ * Open the read-only perfect hash table for a CSV file twice: the first time
+ * builds the index and saves it next to the CSV (unless it was already there),
+ * the second time just maps that file. Then every bid gets looked up in it, and
+ * a million random lookups get timed against the chained table.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkPerfectHash(const string& csvPath) {
+    unique_ptr<PerfectHashTable> perfect;
+    for (int pass = 0; pass < 2; ++pass) {
+        clock_t ticks = clock();
+        try {
+            perfect = PerfectHashTable::open(csvPath);
+        } catch (csv::Error &e) {
+            std::cerr << e.what() << std::endl;
+            return;
+        }
+        ticks = clock() - ticks;
+        cout << (perfect->fromFile() ? "mapped " : "built ") << csvPath << ".mph in "
+             << ticks * 1.0 / CLOCKS_PER_SEC << " seconds: " << perfect->size() << " ids, "
+             << perfect->bitsPerKey() << " bits/id for the hash, " << perfect->bytes() << " bytes in all" << endl;
+    }
+
+    vector<Bid> bids;
+    if (!readBids(csvPath, bids)) {
+        return;
+    }
+    HashTable table;
+    table.reserve(bids.size());
+    for (const Bid& bid : bids) {
+        table.Insert(bid);
+    }
+
+    // every bid has to come back (the first one, for duplicate ids), and no made up ones
+    size_t wrong = 0;
+    Bid found;
+    for (const Bid& bid : bids) {
+        const Bid* expected = table.Find(bid.bidId);
+        if (!perfect->Find(bid.bidId, found) || found.title != expected->title || found.amount != expected->amount) {
+            ++wrong;
+        }
+        if (perfect->Find(bid.bidId + "x", found)) {
+            ++wrong;
+        }
+    }
+    if (wrong != 0) {
+        cout << wrong << " lookups went wrong!" << endl;
+    }
+
+    vector<string_view> lookups(1000000);
+    uint64_t x = 88172645463325252ull;
+    for (string_view& id : lookups) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        id = bids[x % bids.size()].bidId;
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        clock_t ticks = clock();
+        size_t hits = 0;
+        for (string_view id : lookups) {
+            if (pass == 0) {
+                const Bid* bid = table.Find(id);
+                if (bid != nullptr) {
+                    found = *bid;
+                    ++hits;
+                }
+            } else {
+                hits += perfect->Find(id, found);
+            }
+        }
+        ticks = clock() - ticks;
+        cout << (pass == 0 ? "chained: " : "perfect: ") << lookups.size() / (ticks * 1.0 / CLOCKS_PER_SEC) / 1000000.0
+             << " M lookups/s" << endl;
+    }
+}
+
+/**
+ * The one and only main() method
+ */
+int main(int argc, char* argv[]) {
+
+    // process command line arguments
+    // an optional third argument picks the table: "chained" (the default), "incremental"
+    // (chained, growing a few buckets at a time), "bloom" (chained, with a Bloom filter in
+    // front of it), "open", "concurrent" or "disk" (kept in <csv>.idx and <csv>.dat, so the
+    // bids are still there next time)
+    string csvPath, bidKey, backend = "chained";
+    switch (argc) {
+        case 4:
+            csvPath = argv[1];
+            bidKey = argv[2];
+            backend = argv[3];
+            break;
+        case 2:
+            csvPath = argv[1];
+            bidKey = "98109";
+            break;
+        case 3:
+            csvPath = argv[1];
+            bidKey = argv[2];
+            break;
+        default:
+            csvPath = "eBid_Monthly_Sales_Dec_2016.csv";
             //bidKey = "98109"; //btw, this bid is not contained in the Dec 2016 sample data
             //but we can try bid ID 98268 or 98094 instead
             bidKey = "98094";
@@ -457,10 +3296,42 @@ int main(int argc, char* argv[]) {
     clock_t ticks;
 
     // Define a hash table to hold all the bids
-    HashTable* bidTable;
+    BidTable* bidTable;
+
+    DiskHashTable* disk = nullptr;
 
     Bid bid;
-    bidTable = new HashTable();
+    if (backend == "disk") {
+        ticks = clock();
+        try {
+            disk = new DiskHashTable(csvPath);
+        } catch (csv::Error &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        ticks = clock() - ticks;
+        bidTable = disk;
+        cout << "Using the on-disk hash table " << csvPath << ".idx, " << disk->size() << " bids, opened in "
+             << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+    } else if (backend == "open") {
+        bidTable = new OpenHashTable();
+        cout << "Using the open addressing (Robin Hood) hash table" << endl;
+    } else if (backend == "concurrent") {
+        bidTable = new ConcurrentHashTable();
+        cout << "Using the concurrent hash table" << endl;
+    } else if (backend == "incremental") {
+        HashTable* chained = new HashTable();
+        chained->setIncrementalRehash(true);
+        bidTable = chained;
+        cout << "Using the chained hash table with incremental rehashing" << endl;
+    } else if (backend == "bloom") {
+        HashTable* chained = new HashTable();
+        chained->enableFilter();
+        bidTable = chained;
+        cout << "Using a Bloom filter in front of the chained hash table" << endl;
+    } else {
+        bidTable = new HashTable();
+    }
 
     int choice = 0;
     while (choice != 9) {
@@ -469,6 +3340,13 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Benchmark CSV Scanner" << endl;
+        cout << "  6. Benchmark Hash Functions" << endl;
+        cout << "  7. Benchmark Concurrent Reads" << endl;
+        cout << "  8. Benchmark Batch Lookup" << endl;
+        cout << " 10. Benchmark Bloom Filter" << endl;
+        cout << " 11. Build Perfect Hash Index" << endl;
+        cout << " 12. Compact Disk Table" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -513,10 +3391,59 @@ int main(int argc, char* argv[]) {
             case 4:
                 bidTable->Remove(bidKey);
                 break;
+
+            case 5:
+                benchmarkScanner(csvPath);
+                break;
+
+            case 6:
+                benchmarkHashFunctions(csvPath);
+                break;
+
+            case 7:
+                benchmarkConcurrentReads(csvPath);
+                break;
+
+            case 8:
+                benchmarkBatchLookup(csvPath);
+                break;
+
+            case 10:
+                benchmarkBloomFilter(csvPath);
+                break;
+
+            case 11:
+                benchmarkPerfectHash(csvPath);
+                break;
+
+            case 12:
+                if (disk == nullptr) {
+                    cout << "Only the disk table (third argument \"disk\") gets compacted" << endl;
+                    break;
+                }
+                cout << disk->dataBytes() << " bytes of bids before" << endl;
+                ticks = clock();
+                try {
+                    disk->compact();
+                } catch (csv::Error &e) {
+                    std::cerr << e.what() << std::endl;
+                }
+                ticks = clock() - ticks;
+                if (!disk->isOpen()) {
+                    // couldn't even go back to the files that were there, so there's no table left to use
+                    cout << "The disk table couldn't be opened again" << endl;
+                    delete bidTable;
+                    return 1;
+                }
+                cout << disk->dataBytes() << " bytes after, " << disk->size() << " bids" << endl;
+                cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+                break;
         }
     }
 
     cout << "Good bye." << endl;
 
+    delete bidTable;
+
     return 0;
 }
@@ -89,28 +89,31 @@ BinarySearchTree::BinarySearchTree() {
 
 //Destructor
 BinarySearchTree::~BinarySearchTree() {
-    // recurse from root deleting every node
+    // delete every node, starting from root
     //Got some help from this video: https://www.youtube.com/watch?v=ozBhVQNSJ9E
     if (root != nullptr) {
         removeSubtree(root);
     }
 }
-//recursive helper for destructor:
+//helper for destructor:
 void BinarySearchTree::removeSubtree(Node* node) {
-    if(node->left != nullptr) {
-        removeSubtree(node->left); //this will recursively drill down the left-most subtree
-    }
+    //no recursion (a course list read in sorted order makes the tree one long line, deeper than the stack):
+    //while the node on top has a left child, rotate right so the left child comes up on top,
+    //and once it has none, delete it and carry on with its right subtree
+    while (node != nullptr) {
+        if (node->left != nullptr) {
+            Node* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            Node* right = node->right;
 
-    if(node->right != nullptr) {
-        removeSubtree(node->right);
+            //cout << "Deleting node with course number:: " << node->course.courseNumber;
+            delete node;
+            node = right;
+        }
     }
-
-    //if we've made it this far, then we've gone as far left and as far right as possible
-    //delete the current node, then allow the recursion to unwind and delete trace the parent's right subtree
-    //if no right subtree exists, then delete that node and unwind a further level up the tree towards the root
-
-    //cout << "Deleting node with course number:: " << node->course.courseNumber;
-    delete node;
 }
 
 //Public Traversals
@@ -146,55 +149,49 @@ void BinarySearchTree::Remove(const string& courseNumber) {
 }
 //private removal helper
 Node* BinarySearchTree::removeNode(Node* node, const string& courseNumber) {
-    // If the node is null, then the node with the courseNumber could not be found in the string.
-    if (node == nullptr) {
-        return nullptr;
-    }
+    //walks down in a loop instead of recursing. "link" is the pointer that points at the node
+    //we're looking at: node itself to start with, then some node's left or right
+    Node** link = &node;
 
-    //function will recursive traverse down left or down right,
     // depending on if the target courseNumber is less than or greater than the courseNumber in the current node
+    // go left or right, until we find it... or run off the bottom, and then it isn't in the tree
+    while (*link != nullptr && (*link)->course.courseNumber != courseNumber) {
+        // If target courseNumber is less than the current node's courseNumber, go left, if it's greater, go right
+        link = courseNumber < (*link)->course.courseNumber ? &(*link)->left : &(*link)->right;
+    }
+    if (*link == nullptr) {
+        return node;
+    }
 
-    // If target courseNumber is less than the current node's courseNumber, go left
-    if (courseNumber < node->course.courseNumber) {
-        node->left = removeNode(node->left, courseNumber);
-    } else if (courseNumber > node->course.courseNumber) {
-        // If target courseNumber is greater than the current node's courseNumber, go right
-        node->right = removeNode(node->right, courseNumber);
-    } else {
-        //neither greater than nor less than, therefore equals... therefore this is the target node to delete!
-        //and we're assuming courseNumber are unique!
+    //neither greater than nor less than, therefore equals... therefore this is the target node to delete!
+    //and we're assuming courseNumber are unique!
+    Node* target = *link;
 
-        // Case 1: Node with only one child or no child
-        if (node->left == nullptr) {
-            //left child doesn't exist, so we will pop up the right child and then delete the current node.
-            Node* temp = node->right;
-            delete node;
-            return temp;
-        } else if (node->right == nullptr) {
-            //same same but right doesn't exist... pop left
-            Node* temp = node->left;
-            delete node;
-            return temp;
-        }
+    // Case 1: Node with only one child or no child
+    if (target->left == nullptr || target->right == nullptr) {
+        //whichever child exists (or nullptr) gets popped up into the target's place, then delete the target
+        *link = target->left != nullptr ? target->left : target->right;
+        delete target;
+        return node;
+    }
 
-        // Case 2: Node with two children
-        // Get the inorder successor (smallest in the right subtree, aka left-most in the right subtree)
-        Node* temp = node->right;
-        //I wanted to use the existing inOrder() method but that's a void...
-        //would need to create a new helper method just for this method... nah let's just insert logic here.
-        while (temp->left != nullptr) {
-            temp = temp->left;
-        }
+    // Case 2: Node with two children
+    // Get the inorder successor (smallest in the right subtree, aka left-most in the right subtree)
+    Node** successor = &target->right;
+    while ((*successor)->left != nullptr) {
+        successor = &(*successor)->left;
+    }
 
-        // Copy the inorder successor's content to this node
-        //this step is crucial, it ensures that the BST still maintains order
-        node->course = temp->course;
+    // Move the inorder successor's content to this node
+    //this step is crucial, it ensures that the BST still maintains order
+    Node* temp = *successor;
+    target->course = std::move(temp->course);
 
-        // Delete the inorder successor...
-        //really, we are replacing the target node (for deletion) with its inorder successor
-        //this way, there are no duplicate nodes in the BST
-        node->right = removeNode(node->right, temp->course.courseNumber);
-    }
+    // Delete the inorder successor...
+    //really, we are replacing the target node (for deletion) with its inorder successor
+    //this way, there are no duplicate nodes in the BST. It has no left child, so its right one takes its place
+    *successor = temp->right;
+    delete temp;
 
     return node;
 }
@@ -232,59 +229,86 @@ Course BinarySearchTree::Search(const string& courseNumber) {
 //private helper for inserting nodes
 void BinarySearchTree::addNode(Node* node, const Course& course) {
     //"course" is the new thing we want to add
-    //I made it constant to avoid copying it with every recursive call
-
-    //"node" is the address of a node we are contemplating adding to
-    // if existing node is larger (alphabetically), then add the new node to left
-    //this step is crucial for keeping our BST alphabetically ordered!
-    if(node->course.courseNumber > course.courseNumber)
-
-        if (node->left == nullptr) {// if no left node (left child is null)
-            // this "course" becomes left node...create new node containing the course
-            node->left = new Node(course);
-        }
-        else {// else recurse down the left node
-            //left node is not null, so need to decide whether course should go left or right of that left child
-            addNode(node->left, course);
-        }
-    else {//the new courseNumber is greater, or equal to, the existing node... go right
-
-        if (node->right == nullptr) {// if no right node...
-            //if right child is null, insert new course as right child
-            node->right = new Node(course);
-        } else {
-            // recurse down the right subtree
-            addNode(node->right, course);
+    //I made it constant to avoid copying it
+
+    //"node" is the address of a node we are contemplating adding to, walk down (in a loop, not recursion)
+    //until the side we need to go to is empty
+    while (true) {
+        // if existing node is larger (alphabetically), then add the new node to left
+        //this step is crucial for keeping our BST alphabetically ordered!
+        //otherwise the new courseNumber is greater, or equal to, the existing node... go right
+        Node*& child = node->course.courseNumber > course.courseNumber ? node->left : node->right;
+
+        if (child == nullptr) {// if no child on that side...
+            // this "course" becomes that child...create new node containing the course
+            child = new Node(course);
+            return;
         }
+        //child is not null, so need to decide whether course should go left or right of that child
+        node = child;
     }
 }
 
 //private helpers for traversal
 void BinarySearchTree::inOrder(Node* node) {
-    //if node is not equal to null ptr
-    if (node != nullptr) {
-        inOrder(node->left);
+    //Morris traversal, no recursion and no stack: before going down into a left subtree, its
+    //right-most node gets its empty right pointer aimed back at "node" to find the way back up,
+    //and the second time we get there it's taken out again
+    while (node != nullptr) {
+        if (node->left != nullptr) {
+            Node* predecessor = node->left;
+            while (predecessor->right != nullptr && predecessor->right != node) {
+                predecessor = predecessor->right;
+            }
+            if (predecessor->right == nullptr) {
+                predecessor->right = node;
+                node = node->left;
+                continue;
+            }
+            predecessor->right = nullptr;
+        }
 
         //output course number, course title
         cout << node->course.courseNumber << ": " << node->course.courseName << endl;
 
-        inOrder(node->right);
+        node = node->right;
     }
 }
 void BinarySearchTree::postOrder(Node* node) {
-    if (node != nullptr) {
-        postOrder(node->left);
-        postOrder(node->right);
-        //output course number, course title
-        cout << node->course.courseNumber << ": " << node->course.courseName << endl;
+    //stack of the nodes still waiting on their subtrees, instead of recursion
+    vector<Node*> stack;
+    Node* last = nullptr; //the node printed last, tells us whether a right subtree is done
+    while (node != nullptr || !stack.empty()) {
+        if (node != nullptr) {
+            stack.push_back(node);
+            node = node->left;
+        } else if (stack.back()->right != nullptr && stack.back()->right != last) {
+            node = stack.back()->right;
+        } else {
+            last = stack.back();
+            stack.pop_back();
+            //output course number, course title
+            cout << last->course.courseNumber << ": " << last->course.courseName << endl;
+        }
     }
 }
 void BinarySearchTree::preOrder(Node* node) {
+    //stack of the subtrees still to do (right goes on first so left comes off first)
+    vector<Node*> stack;
     if (node != nullptr) {
+        stack.push_back(node);
+    }
+    while (!stack.empty()) {
+        node = stack.back();
+        stack.pop_back();
         //output course number, course title
         cout << node->course.courseNumber << ": " << node->course.courseName << endl;
-        preOrder(node->left);
-        preOrder(node->right);
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
     }
 }
 
@@ -1,49 +1,85 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <filesystem>
 #include "CSVparser.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define CSV_SIMD_X86
+# include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 namespace csv {
 
-    Parser::Parser(const std::string &data, const DataType &type, char sep)
-            : _type(type), _sep(sep)
+    /*
+    ** CONVERSION
+    */
+
+    std::string_view trimField(std::string_view text)
     {
-        std::string line;
-        if (type == eFILE)
-        {
-            _file = data;
-            std::ifstream ifile(_file.c_str());
-            if (ifile.is_open())
-            {
-                while (ifile.good())
-                {
-                    getline(ifile, line);
-                    if (!line.empty())
-                        _originalFile.push_back(line);
-                }
-                ifile.close();
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+            text.remove_suffix(1);
+
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+            return trimField(text.substr(1, text.size() - 2));
+        return text;
+    }
 
-                if (_originalFile.empty())
-                    throw Error(std::string("No Data in ").append(_file));
+    std::errc toMoney(std::string_view text, double &out)
+    {
+        // copy the digits to a stack buffer without '$' and the thousands separators
+        char digits[64];
+        std::size_t length = 0;
 
-                parseHeader();
-                parseContent();
-            }
-            else
-                throw Error(std::string("Failed to open ").append(_file));
+        text = trimField(text);
+        for (char c : text)
+        {
+            if (c == '$' || c == ',')
+                continue;
+            if (length == sizeof(digits))
+                return std::errc::result_out_of_range;
+            digits[length++] = c;
         }
-        else
+        return toNumber(std::string_view(digits, length), out);
+    }
+
+    Parser::Parser(const std::string &data, const DataType &type, char sep, unsigned int threads)
+            : Parser(data, Columns(), type, sep, threads) {}
+
+    Parser::Parser(const std::string &data, const Columns &columns, const DataType &type, char sep, unsigned int threads)
+            : _type(type), _sep(sep), _threads(threads), _columns(columns), _synced(0), _reordered(false)
+    {
+        if (type == eFILE)
         {
-            std::istringstream stream(data);
-            while (std::getline(stream, line))
-                if (!line.empty())
-                    _originalFile.push_back(line);
-            if (_originalFile.empty())
-                throw Error(std::string("No Data in pure content"));
+            _file = data;
 
-            parseHeader();
-            parseContent();
+            // the mapping is only needed while parsing, rows own copies of their values
+            MappedFile map(_file);
+            parse(map.view());
         }
+        else
+            parse(data);
     }
 
     Parser::~Parser()
@@ -54,48 +90,174 @@ namespace csv {
             delete *it;
     }
 
-    void Parser::parseHeader()
+    void Parser::parse(std::string_view text)
     {
-        std::stringstream ss(_originalFile[0]);
-        std::string item;
+        // the header is the first non-empty line
+        while (!text.empty())
+        {
+            std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            parseHeader(line);
+            try
+            {
+                parseContent(text);
+                _synced = _content.size();
+            }
+            catch (...)
+            {
+                // the destructor won't run if the constructor throws
+                for (Row *row : _content)
+                    delete row;
+                _content.clear();
+                throw;
+            }
+            return;
+        }
+
+        if (_type == eFILE)
+            throw Error(std::string("No Data in ").append(_file));
+        throw Error(std::string("No Data in pure content"));
+    }
 
-        while (std::getline(ss, item, _sep))
-            _header.push_back(item);
+    void Parser::parseHeader(std::string_view line)
+    {
+        // split the same way as the rows, so a quoted name with _sep in it stays one column
+        std::vector<std::string_view> header;
+        splitLine(line, _sep, header);
+        _schema = std::make_shared<const Schema>(std::vector<std::string>(header.begin(), header.end()), _columns);
     }
 
-    void Parser::parseContent()
+    void Parser::parseContent(std::string_view text)
     {
-        std::vector<std::string>::iterator it;
+        const std::size_t minChunk = 1 << 20;
 
-        it = _originalFile.begin();
-        it++; // skip header
+        unsigned int workers = _threads != 0 ? _threads : std::thread::hardware_concurrency();
+        if (workers == 0)
+            workers = 1;
+        if (workers > text.size() / minChunk + 1)
+            workers = static_cast<unsigned int>(text.size() / minChunk + 1);
 
-        for (; it != _originalFile.end(); it++)
+        if (workers == 1)
         {
-            bool quoted = false;
-            int tokenStart = 0;
-            unsigned int i = 0;
+            parseChunk(text, _content);
+            return;
+        }
 
-            Row *row = new Row(_header);
+        // Cut the text into roughly equal byte ranges and push every cut forward to
+        // the start of the next line. Quote state resets at each line (rows never span
+        // lines in this format), so any newline is a safe row boundary.
+        std::vector<std::size_t> bounds(workers + 1, text.size());
+        bounds[0] = 0;
+        for (unsigned int k = 1; k < workers; k++)
+        {
+            std::size_t cut = text.size() / workers * k;
+            if (cut < bounds[k - 1])
+                cut = bounds[k - 1];
+            std::size_t nl = text.find('\n', cut);
+            bounds[k] = nl == std::string_view::npos ? text.size() : nl + 1;
+        }
 
-            for (; i != it->length(); i++)
+        // every worker fills its own buffer, they're stitched back in file order after
+        std::vector<std::vector<Row *>> parts(workers);
+        std::vector<std::future<void>> jobs;
+        std::exception_ptr error;
+        try
+        {
+            for (unsigned int k = 0; k < workers; k++)
             {
-                if (it->at(i) == '"')
-                    quoted = !(quoted);
-                else if (it->at(i) == ',' && !quoted)
+                std::string_view chunk = text.substr(bounds[k], bounds[k + 1] - bounds[k]);
+                jobs.push_back(std::async(std::launch::async, [this, chunk, &parts, k]()
                 {
-                    row->push(it->substr(tokenStart, i - tokenStart));
-                    tokenStart = i + 1;
-                }
+                    parseChunk(chunk, parts[k]);
+                }));
             }
+        }
+        catch (...)
+        {
+            // no thread for the next chunk, the ones already started still have to finish
+            error = std::current_exception();
+        }
 
-            //end
-            row->push(it->substr(tokenStart, it->length() - tokenStart));
+        for (std::future<void> &job : jobs)
+        {
+            try
+            {
+                job.get();
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+
+        // once the room is reserved the inserts below can't throw, so no row is ever in
+        // neither parts nor _content
+        std::size_t total = 0;
+        for (const std::vector<Row *> &part : parts)
+            total += part.size();
+        if (!error)
+        {
+            try
+            {
+                _content.reserve(_content.size() + total);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+
+        if (error)
+        {
+            for (std::vector<Row *> &part : parts)
+                for (Row *row : part)
+                    delete row;
+            std::rethrow_exception(error);
+        }
+        for (std::vector<Row *> &part : parts)
+            _content.insert(_content.end(), part.begin(), part.end());
+    }
+
+    void Parser::parseChunk(std::string_view chunk, std::vector<Row *> &rows) const
+    {
+        std::vector<std::string_view> fields;
+        std::size_t pos = 0;
+
+        while (pos < chunk.size())
+        {
+            std::size_t end = chunk.find('\n', pos);
+            if (end == std::string_view::npos)
+                end = chunk.size();
+
+            std::string_view line = chunk.substr(pos, end - pos);
+            pos = end + 1;
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            fields.clear();
+            splitLine(line, _sep, fields);
 
             // if value(s) missing
-            if (row->size() != _header.size())
+            if (fields.size() != _schema->size())
                 throw Error("corrupted data !");
-            _content.push_back(row);
+
+            std::unique_ptr<Row> row(new Row(_schema));
+            for (unsigned int i = 0; i < fields.size(); i++)
+                if (_schema->keeps(i))
+                    row->push(std::string(fields[i]));
+            rows.push_back(row.get());
+            row.release();
         }
     }
 
@@ -118,19 +280,24 @@ namespace csv {
 
     unsigned int Parser::columnCount() const
     {
-        return _header.size();
+        return _schema->size();
     }
 
     std::vector<std::string> Parser::getHeader() const
     {
-        return _header;
+        return _schema->names();
     }
 
     const std::string Parser::getHeaderElement(unsigned int pos) const
     {
-        if (pos >= _header.size())
+        if (pos >= _schema->size())
             throw Error("can't return this header (doesn't exist)");
-        return _header[pos];
+        return _schema->name(pos);
+    }
+
+    const Schema &Parser::getSchema() const
+    {
+        return *_schema;
     }
 
     bool Parser::deleteRow(unsigned int pos)
@@ -139,6 +306,7 @@ namespace csv {
         {
             delete *(_content.begin() + pos);
             _content.erase(_content.begin() + pos);
+            _reordered = true;
             return true;
         }
         return false;
@@ -146,42 +314,186 @@ namespace csv {
 
     bool Parser::addRow(unsigned int pos, const std::vector<std::string> &r)
     {
-        Row *row = new Row(_header);
+        if (pos > _content.size())
+            return false;
+
+        // r holds a full row of the file, only the loaded columns are kept
+        Row *row = new Row(_schema);
+        for (unsigned int i = 0; i < r.size(); i++)
+            if (_schema->keeps(i))
+                row->push(r[i]);
+
+        if (pos < _synced)
+            _reordered = true;
+        _content.insert(_content.begin() + pos, row);
+        return true;
+    }
+
+    void Parser::sync(SyncMode mode) const
+    {
+        // writing back would silently drop the columns that were never loaded
+        if (_schema->projected())
+            throw Error("can't sync a file parsed with only some of its columns");
 
-        for (auto it = r.begin(); it != r.end(); it++)
-            row->push(*it);
+        if (_type != DataType::eFILE)
+            return;
 
-        if (pos <= _content.size())
+        if (mode == eSYNC_CHANGED && !_reordered && _synced <= _content.size())
         {
-            _content.insert(_content.begin() + pos, row);
-            return true;
+            bool changed = false;
+            for (std::size_t i = 0; i < _synced && !changed; i++)
+                changed = _content[i]->_changed;
+
+            if (!changed)
+            {
+                if (_synced < _content.size())
+                    appendFrom(_synced);
+                _synced = _content.size();
+                return;
+            }
         }
-        return false;
+
+        writeAll();
+        for (Row *row : _content)
+            row->_changed = false;
+        _synced = _content.size();
+        _reordered = false;
+    }
+
+    // Push a file's data out of the OS cache onto the disk. Without it, after a crash a rename
+    // that made it to the disk can still point at a file whose contents didn't (empty or cut off).
+    static bool flushToDisk(const std::string &file)
+    {
+#ifdef _WIN32
+        HANDLE h = CreateFileA(file.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE)
+            return false;
+        bool ok = FlushFileBuffers(h) != 0;
+        CloseHandle(h);
+        return ok;
+#else
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    // Same for the directory a file was just renamed in, so the rename itself is on the disk.
+    // Windows has no way to open a directory for this, there the rename is journaled anyway.
+    static void flushDirectoryOf(const std::string &file)
+    {
+#ifndef _WIN32
+        std::string dir = std::filesystem::path(file).parent_path().string();
+        int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#endif
+    }
+
+    void Parser::writeRow(std::string &out, const Row &row) const
+    {
+        for (std::size_t i = 0; i < row._values.size(); i++)
+        {
+            if (i > 0)
+                out += _sep;
+            out += row._values[i];
+        }
+        out += '\n';
     }
 
-    void Parser::sync() const
+    void Parser::writeAll() const
     {
-        if (_type == DataType::eFILE)
+        // Rows are formatted into a big buffer that goes out in a few large writes,
+        // into a temp file that only replaces the real one once it's complete.
+        // A crash half way leaves the old file untouched.
+        const std::size_t flushAt = 1 << 20;
+        std::string temp = _file + ".tmp";
+        std::ofstream f(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!f.is_open())
+            throw Error(std::string("Failed to open ").append(temp));
+
+        std::string out;
+        out.reserve(flushAt + 4096);
+
+        // header
+        const std::vector<std::string> &header = _schema->names();
+        for (std::size_t i = 0; i < header.size(); i++)
         {
-            std::ofstream f;
-            f.open(_file, std::ios::out | std::ios::trunc);
+            if (i > 0)
+                out += _sep;
+            out += header[i];
+        }
+        out += '\n';
 
-            // header
-            unsigned int i = 0;
-            for (auto it = _header.begin(); it != _header.end(); it++)
+        for (const Row *row : _content)
+        {
+            writeRow(out, *row);
+            if (out.size() >= flushAt)
             {
-                f << *it;
-                if (i < _header.size() - 1)
-                    f << ",";
-                else
-                    f << std::endl;
-                i++;
+                f.write(out.data(), static_cast<std::streamsize>(out.size()));
+                out.clear();
             }
+        }
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        f.close();
+
+        // the temp file has to be on the disk before the rename is, and then the rename too
+        std::error_code ec;
+        if (!f || !flushToDisk(temp))
+        {
+            std::filesystem::remove(temp, ec);
+            throw Error(std::string("Failed to write ").append(temp));
+        }
+
+        // the temp file got the default mode, give it the real file's so the rename doesn't change it
+        std::filesystem::file_status original = std::filesystem::status(_file, ec);
+        if (!ec && std::filesystem::exists(original))
+            std::filesystem::permissions(temp, original.permissions(), ec);
+
+        std::filesystem::rename(temp, _file, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temp, ec);
+            throw Error(std::string("Failed to replace ").append(_file));
+        }
+        flushDirectoryOf(_file);
+    }
 
-            for (auto it = _content.begin(); it != _content.end(); it++)
-                f << **it << std::endl;
-            f.close();
+    // Not crash-safe the way writeAll() is: the new rows go onto the end of the real file,
+    // so a crash part way can leave the last row cut off (the rows before it are untouched).
+    // Going through a temp file would mean copying the whole file, which is what this avoids.
+    void Parser::appendFrom(std::size_t first) const
+    {
+        std::string out;
+
+        // the file may not end with a newline, don't glue the first new row onto the last old one
+        {
+            std::ifstream in(_file, std::ios::in | std::ios::binary | std::ios::ate);
+            if (in.is_open() && in.tellg() > 0)
+            {
+                char last = '\n';
+                in.seekg(-1, std::ios::end);
+                in.get(last);
+                if (last != '\n')
+                    out += '\n';
+            }
         }
+
+        for (std::size_t i = first; i < _content.size(); i++)
+            writeRow(out, *_content[i]);
+
+        std::ofstream f(_file, std::ios::out | std::ios::binary | std::ios::app);
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        f.close();
+        if (!f || !flushToDisk(_file))
+            throw Error(std::string("Failed to append to ").append(_file));
     }
 
     const std::string &Parser::getFileName() const
@@ -189,12 +501,114 @@ namespace csv {
         return _file;
     }
 
+    /*
+    ** COLUMNS
+    */
+
+    Columns::Columns(std::initializer_list<unsigned int> positions)
+            : _positions(positions) {}
+
+    Columns::Columns(std::initializer_list<std::string> names)
+            : _names(names) {}
+
+    Columns &Columns::add(unsigned int pos)
+    {
+        _positions.push_back(pos);
+        return *this;
+    }
+
+    Columns &Columns::add(const std::string &name)
+    {
+        _names.push_back(name);
+        return *this;
+    }
+
+    bool Columns::empty() const
+    {
+        return _positions.empty() && _names.empty();
+    }
+
+    /*
+    ** SCHEMA
+    */
+
+    Schema::Schema(std::vector<std::string> names, const Columns &columns)
+            : _names(std::move(names)), _width(0)
+    {
+        // emplace keeps the first column when a name shows up twice, like the old linear scan
+        _index.reserve(_names.size());
+        for (unsigned int i = 0; i < _names.size(); i++)
+            _index.emplace(_names[i], i);
+
+        std::vector<bool> keep(_names.size(), columns.empty());
+        for (unsigned int pos : columns._positions)
+        {
+            if (pos >= _names.size())
+                throw Error(std::string("no column at position ").append(std::to_string(pos)));
+            keep[pos] = true;
+        }
+        for (const std::string &name : columns._names)
+            keep[column(name)] = true;
+
+        // loaded columns keep their file order in the row
+        _slots.assign(_names.size(), npos);
+        for (unsigned int i = 0; i < _names.size(); i++)
+            if (keep[i])
+                _slots[i] = _width++;
+    }
+
+    unsigned int Schema::size() const
+    {
+        return _names.size();
+    }
+
+    const std::vector<std::string> &Schema::names() const
+    {
+        return _names;
+    }
+
+    const std::string &Schema::name(unsigned int pos) const
+    {
+        if (pos >= _names.size())
+            throw Error("can't return this header (doesn't exist)");
+        return _names[pos];
+    }
+
+    unsigned int Schema::find(std::string_view name) const
+    {
+        auto it = _index.find(name);
+        return it == _index.end() ? npos : it->second;
+    }
+
+    unsigned int Schema::width() const
+    {
+        return _width;
+    }
+
+    bool Schema::projected() const
+    {
+        return _width != _names.size();
+    }
+
+    bool Schema::keeps(unsigned int pos) const
+    {
+        return slot(pos) != npos;
+    }
+
+    unsigned int Schema::column(std::string_view name) const
+    {
+        unsigned int pos = find(name);
+        if (pos == npos)
+            throw Error(std::string("no column named ").append(name));
+        return pos;
+    }
+
     /*
     ** ROW
     */
 
-    Row::Row(const std::vector<std::string> &header)
-            : _header(header) {}
+    Row::Row(std::shared_ptr<const Schema> schema)
+            : _schema(std::move(schema)), _changed(false) {}
 
     Row::~Row() = default; //changed from "Row::~Row() {}", just style preference
 
@@ -203,48 +617,38 @@ namespace csv {
         return _values.size();
     }
 
-    void Row::push(const std::string &value)
+    void Row::push(std::string value)
     {
-        _values.push_back(value);
+        _values.push_back(std::move(value));
     }
 
     bool Row::set(const std::string &key, const std::string &value)
     {
-        std::vector<std::string>::const_iterator it;
-        int pos = 0;
+        unsigned int slot = _schema->slot(_schema->find(key));
 
-        for (it = _header.begin(); it != _header.end(); it++)
-        {
-            if (key == *it)
-            {
-                _values[pos] = value;
-                return true;
-            }
-            pos++;
-        }
-        return false;
+        if (slot >= _values.size())
+            return false;
+        _values[slot] = value;
+        _changed = true;
+        return true;
     }
 
     const std::string Row::operator[](unsigned int valuePosition) const
     {
-        if (valuePosition < _values.size())
-            return _values[valuePosition];
+        unsigned int slot = _schema->slot(valuePosition);
+
+        if (slot < _values.size())
+            return _values[slot];
         throw Error("can't return this value (doesn't exist)");
     }
 
     const std::string Row::operator[](const std::string &key) const
     {
-        std::vector<std::string>::const_iterator it;
-        int pos = 0;
-
-        for (it = _header.begin(); it != _header.end(); it++)
-        {
-            if (key == *it)
-                return _values[pos];
-            pos++;
-        }
+        unsigned int slot = _schema->slot(_schema->find(key));
 
-        throw Error("can't return this value (doesn't exist)");
+        if (slot >= _values.size())
+            throw Error("can't return this value (doesn't exist)");
+        return _values[slot];
     }
 
     std::ostream &operator<<(std::ostream &os, const Row &row)
@@ -265,4 +669,1026 @@ namespace csv {
         }
         return os;
     }
+
+    /*
+    ** MAPPED FILE
+    */
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &file)
+            : _data(nullptr), _size(0), _handle(nullptr)
+    {
+        HANDLE h = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (h == INVALID_HANDLE_VALUE)
+            throw Error(std::string("Failed to open ").append(file));
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(h, &size))
+        {
+            CloseHandle(h);
+            throw Error(std::string("Failed to read size of ").append(file));
+        }
+        _size = static_cast<std::size_t>(size.QuadPart);
+
+        // an empty file can't be mapped, leave _data as nullptr
+        if (_size > 0)
+        {
+            _handle = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_handle != nullptr)
+                _data = static_cast<const char *>(MapViewOfFile(_handle, FILE_MAP_READ, 0, 0, 0));
+            if (_data == nullptr)
+            {
+                if (_handle != nullptr)
+                    CloseHandle(_handle);
+                CloseHandle(h);
+                throw Error(std::string("Failed to map ").append(file));
+            }
+        }
+        CloseHandle(h); // the mapping keeps the file open
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data != nullptr)
+            UnmapViewOfFile(_data);
+        if (_handle != nullptr)
+            CloseHandle(_handle);
+    }
+#else
+    MappedFile::MappedFile(const std::string &file)
+            : _data(nullptr), _size(0), _handle(nullptr)
+    {
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw Error(std::string("Failed to open ").append(file));
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw Error(std::string("Failed to read size of ").append(file));
+        }
+        _size = static_cast<std::size_t>(st.st_size);
+
+        // an empty file can't be mapped, leave _data as nullptr
+        if (_size > 0)
+        {
+            void *p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw Error(std::string("Failed to map ").append(file));
+            }
+            ::madvise(p, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const char *>(p);
+        }
+        ::close(fd); // the mapping keeps the file open
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data != nullptr)
+            ::munmap(const_cast<char *>(_data), _size);
+    }
+#endif
+
+    const char *MappedFile::data() const
+    {
+        return _data;
+    }
+
+    std::size_t MappedFile::size() const
+    {
+        return _size;
+    }
+
+    std::string_view MappedFile::view() const
+    {
+        return {_data, _size};
+    }
+
+    /*
+    ** SPLIT
+    */
+
+    namespace
+    {
+        // finishes a line one byte at a time, starting at i with the given quote state
+        void splitTail(std::string_view line, char sep, std::vector<std::string_view> &out,
+                       std::size_t i, std::size_t tokenStart, bool quoted)
+        {
+            for (; i != line.size(); i++)
+            {
+                if (line[i] == '"')
+                    quoted = !(quoted);
+                else if (line[i] == sep && !quoted)
+                {
+                    out.push_back(line.substr(tokenStart, i - tokenStart));
+                    tokenStart = i + 1;
+                }
+            }
+
+            //end
+            out.push_back(line.substr(tokenStart));
+        }
+
+#ifdef CSV_SIMD_X86
+        /*
+        ** The SIMD scanners compare a whole block against '"' and sep, which gives
+        ** one bit per byte. A prefix xor of the quote bits marks every byte that
+        ** sits inside quotes, so separators there are masked out and the rest are
+        ** walked with ctz. The quote state of the last byte carries into the next block.
+        */
+        __attribute__((target("sse2")))
+        void splitSSE2(std::string_view line, char sep, std::vector<std::string_view> &out)
+        {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i comma = _mm_set1_epi8(sep);
+            std::uint32_t inQuotes = 0; // all ones while inside quotes
+            std::size_t tokenStart = 0;
+            std::size_t i = 0;
+
+            for (; i + 16 <= line.size(); i += 16)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line.data() + i));
+                std::uint32_t quotes = _mm_movemask_epi8(_mm_cmpeq_epi8(block, quote));
+                std::uint32_t seps = _mm_movemask_epi8(_mm_cmpeq_epi8(block, comma));
+
+                std::uint32_t quoted = quotes;
+                quoted ^= quoted << 1;
+                quoted ^= quoted << 2;
+                quoted ^= quoted << 4;
+                quoted ^= quoted << 8;
+                quoted = (quoted ^ inQuotes) & 0xFFFFu;
+                inQuotes = (quoted & 0x8000u) ? 0xFFFFFFFFu : 0;
+
+                seps &= ~quoted;
+                while (seps != 0)
+                {
+                    std::size_t pos = i + __builtin_ctz(seps);
+                    out.push_back(line.substr(tokenStart, pos - tokenStart));
+                    tokenStart = pos + 1;
+                    seps &= seps - 1;
+                }
+            }
+            splitTail(line, sep, out, i, tokenStart, inQuotes != 0);
+        }
+
+        __attribute__((target("avx2")))
+        void splitAVX2(std::string_view line, char sep, std::vector<std::string_view> &out)
+        {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i comma = _mm256_set1_epi8(sep);
+            std::uint32_t inQuotes = 0; // all ones while inside quotes
+            std::size_t tokenStart = 0;
+            std::size_t i = 0;
+
+            for (; i + 32 <= line.size(); i += 32)
+            {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(line.data() + i));
+                std::uint32_t quotes = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quote));
+                std::uint32_t seps = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, comma));
+
+                std::uint32_t quoted = quotes;
+                quoted ^= quoted << 1;
+                quoted ^= quoted << 2;
+                quoted ^= quoted << 4;
+                quoted ^= quoted << 8;
+                quoted ^= quoted << 16;
+                quoted ^= inQuotes;
+                inQuotes = (quoted & 0x80000000u) ? 0xFFFFFFFFu : 0;
+
+                seps &= ~quoted;
+                while (seps != 0)
+                {
+                    std::size_t pos = i + __builtin_ctz(seps);
+                    out.push_back(line.substr(tokenStart, pos - tokenStart));
+                    tokenStart = pos + 1;
+                    seps &= seps - 1;
+                }
+            }
+            splitTail(line, sep, out, i, tokenStart, inQuotes != 0);
+        }
+#endif
+
+        ScanLevel _scanLevel = detectScanLevel();
+    }
+
+    ScanLevel detectScanLevel()
+    {
+#ifdef CSV_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return eAVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return eSSE2;
+#endif
+        return eSCALAR;
+    }
+
+    ScanLevel getScanLevel()
+    {
+        return _scanLevel;
+    }
+
+    ScanLevel setScanLevel(ScanLevel level)
+    {
+        ScanLevel best = detectScanLevel();
+        _scanLevel = level < best ? level : best;
+        return _scanLevel;
+    }
+
+    void splitLine(std::string_view line, char sep, std::vector<std::string_view> &out)
+    {
+        switch (_scanLevel)
+        {
+#ifdef CSV_SIMD_X86
+            case eAVX2:
+                splitAVX2(line, sep, out);
+                return;
+            case eSSE2:
+                splitSSE2(line, sep, out);
+                return;
+#endif
+            default:
+                splitTail(line, sep, out, 0, 0, false);
+        }
+    }
+
+    /*
+    ** ROW VIEW
+    */
+
+    RowView::RowView(const std::string_view *fields, unsigned int count, const Schema *schema)
+            : _fields(fields), _size(count), _schema(schema) {}
+
+    unsigned int RowView::size() const
+    {
+        return _size;
+    }
+
+    std::string_view RowView::operator[](unsigned int valuePosition) const
+    {
+        const std::string_view *value = field(valuePosition);
+
+        if (value == nullptr)
+            throw Error("can't return this value (doesn't exist)");
+        return *value;
+    }
+
+    std::errc RowView::getMoney(unsigned int pos, double &out) const
+    {
+        const std::string_view *value = field(pos);
+
+        if (value == nullptr)
+            return std::errc::result_out_of_range;
+        return toMoney(*value, out);
+    }
+
+    std::string_view RowView::operator[](std::string_view key) const
+    {
+        const std::string_view *value = _schema != nullptr ? field(_schema->find(key)) : nullptr;
+
+        if (value == nullptr)
+            throw Error("can't return this value (doesn't exist)");
+        return *value;
+    }
+
+    /*
+    ** MAPPED PARSER
+    */
+
+    MappedParser::MappedParser(const std::string &file, char sep)
+            : MappedParser(file, Columns(), sep) {}
+
+    MappedParser::MappedParser(const std::string &file, const Columns &columns, char sep)
+            : _file(file), _sep(sep), _map(file)
+    {
+        std::string_view data = _map.view();
+        std::vector<std::string_view> fields;
+        std::size_t pos = 0;
+
+        while (pos < data.size())
+        {
+            std::size_t end = data.find('\n', pos);
+            if (end == std::string_view::npos)
+                end = data.size();
+
+            std::string_view line = data.substr(pos, end - pos);
+            pos = end + 1;
+
+            // files saved on Windows end their lines with \r\n
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            if (!_schema)
+            {
+                std::vector<std::string_view> header;
+                splitLine(line, _sep, header);
+                _schema = std::make_shared<const Schema>(std::vector<std::string>(header.begin(), header.end()), columns);
+                continue;
+            }
+
+            fields.clear();
+            splitLine(line, _sep, fields);
+
+            // if value(s) missing
+            if (fields.size() != _schema->size())
+                throw Error("corrupted data !");
+
+            if (!_schema->projected())
+                _fields.insert(_fields.end(), fields.begin(), fields.end());
+            else
+                for (unsigned int i = 0; i < fields.size(); i++)
+                    if (_schema->keeps(i))
+                        _fields.push_back(fields[i]);
+        }
+
+        if (!_schema)
+            throw Error(std::string("No Data in ").append(_file));
+    }
+
+    RowView MappedParser::getRow(unsigned int rowPosition) const
+    {
+        if (rowPosition < rowCount())
+            return RowView(&_fields[rowPosition * _schema->width()], _schema->width(), _schema.get());
+        throw Error("can't return this row (doesn't exist)");
+    }
+
+    RowView MappedParser::operator[](unsigned int rowPosition) const
+    {
+        return MappedParser::getRow(rowPosition);
+    }
+
+    unsigned int MappedParser::rowCount() const
+    {
+        return _fields.size() / _schema->width();
+    }
+
+    unsigned int MappedParser::columnCount() const
+    {
+        return _schema->size();
+    }
+
+    std::vector<std::string> MappedParser::getHeader() const
+    {
+        return _schema->names();
+    }
+
+    const Schema &MappedParser::getSchema() const
+    {
+        return *_schema;
+    }
+
+    const std::string &MappedParser::getFileName() const
+    {
+        return _file;
+    }
+
+    /*
+    ** STREAM
+    */
+
+    Stream::Stream(const std::string &file, char sep, std::size_t bufferSize)
+            : Stream(file, Columns(), sep, bufferSize) {}
+
+    Stream::Stream(const std::string &file, const Columns &columns, char sep, std::size_t bufferSize)
+            : _file(file), _sep(sep), _in(file, std::ios::in | std::ios::binary),
+              _buffer(bufferSize > 0 ? bufferSize : 1), _pos(0), _end(0), _eof(false),
+              _row(nullptr, 0), _rowNumber(0)
+    {
+        if (!_in.is_open())
+            throw Error(std::string("Failed to open ").append(_file));
+
+        std::string_view line;
+        while (readLine(line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            // the header has to outlive the buffer, so it's the one thing we copy
+            splitLine(line, _sep, _fields);
+            _schema = std::make_shared<const Schema>(std::vector<std::string>(_fields.begin(), _fields.end()), columns);
+            _fields.clear();
+            return;
+        }
+        throw Error(std::string("No Data in ").append(_file));
+    }
+
+    bool Stream::next()
+    {
+        std::string_view line;
+
+        while (readLine(line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty())
+                continue;
+
+            _fields.clear();
+            splitLine(line, _sep, _fields);
+
+            // if value(s) missing
+            if (_fields.size() != _schema->size())
+                throw Error("corrupted data !");
+
+            if (!_schema->projected())
+                _row = RowView(_fields.data(), _fields.size(), _schema.get());
+            else
+            {
+                _kept.clear();
+                for (unsigned int i = 0; i < _fields.size(); i++)
+                    if (_schema->keeps(i))
+                        _kept.push_back(_fields[i]);
+                _row = RowView(_kept.data(), _kept.size(), _schema.get());
+            }
+            _rowNumber++;
+            return true;
+        }
+        return false;
+    }
+
+    bool Stream::readLine(std::string_view &line)
+    {
+        for (;;)
+        {
+            const char *start = _buffer.data() + _pos;
+            const void *nl = std::memchr(start, '\n', _end - _pos);
+
+            if (nl != nullptr)
+            {
+                std::size_t length = static_cast<const char *>(nl) - start;
+                line = std::string_view(start, length);
+                _pos += length + 1;
+                return true;
+            }
+            if (_eof)
+            {
+                // last line without a trailing newline
+                if (_pos == _end)
+                    return false;
+                line = std::string_view(start, _end - _pos);
+                _pos = _end;
+                return true;
+            }
+            fill();
+        }
+    }
+
+    void Stream::fill()
+    {
+        // slide the partial line to the front, then top the buffer up
+        std::size_t left = _end - _pos;
+        if (_pos > 0 && left > 0)
+            std::memmove(_buffer.data(), _buffer.data() + _pos, left);
+        _pos = 0;
+        _end = left;
+
+        // one line is bigger than the whole buffer
+        if (_end == _buffer.size())
+            _buffer.resize(_buffer.size() * 2);
+
+        _in.read(_buffer.data() + _end, static_cast<std::streamsize>(_buffer.size() - _end));
+        _end += static_cast<std::size_t>(_in.gcount());
+        if (!_in)
+            _eof = true;
+    }
+
+    Stream::iterator Stream::begin()
+    {
+        return iterator(next() ? this : nullptr);
+    }
+
+    Stream::iterator Stream::end()
+    {
+        return iterator(nullptr);
+    }
+
+    const RowView &Stream::row() const
+    {
+        return _row;
+    }
+
+    unsigned int Stream::rowNumber() const
+    {
+        return _rowNumber;
+    }
+
+    unsigned int Stream::columnCount() const
+    {
+        return _schema->size();
+    }
+
+    const std::vector<std::string> &Stream::getHeader() const
+    {
+        return _schema->names();
+    }
+
+    const Schema &Stream::getSchema() const
+    {
+        return *_schema;
+    }
+
+    const std::string &Stream::getFileName() const
+    {
+        return _file;
+    }
+
+    Stream::iterator::iterator(Stream *stream)
+            : _stream(stream) {}
+
+    Stream::iterator::reference Stream::iterator::operator*() const
+    {
+        return _stream->row();
+    }
+
+    Stream::iterator::pointer Stream::iterator::operator->() const
+    {
+        return &_stream->row();
+    }
+
+    Stream::iterator &Stream::iterator::operator++()
+    {
+        if (_stream != nullptr && !_stream->next())
+            _stream = nullptr;
+        return *this;
+    }
+
+    bool Stream::iterator::operator==(const iterator &other) const
+    {
+        return _stream == other._stream;
+    }
+
+    bool Stream::iterator::operator!=(const iterator &other) const
+    {
+        return _stream != other._stream;
+    }
+
+    /*
+    ** TABLE
+    */
+
+    ColumnSpec::ColumnSpec(unsigned int p, ColumnType t)
+            : pos(p), type(t) {}
+
+    ColumnSpec::ColumnSpec(std::string n, ColumnType t)
+            : pos(0), name(std::move(n)), type(t) {}
+
+    Table::Table()
+            : _rows(0), _checksum(0), _snapshot(false) {}
+
+    // what a parse fills in, one per column, before the Data pointers are aimed at it
+    struct Table::Buffers
+    {
+        std::string bytes;
+        std::vector<std::uint64_t> offsets;
+        std::vector<double> doubles;
+        std::vector<std::int64_t> ints;
+    };
+
+    Table::Table(const std::string &file, const std::vector<ColumnSpec> &columns, char sep, const RowHandler &each)
+            : _rows(0), _checksum(0), _snapshot(false)
+    {
+        if (columns.empty())
+            throw Error("a table needs at least one column");
+
+        Columns wanted;
+        for (const ColumnSpec &spec : columns)
+        {
+            if (spec.name.empty())
+                wanted.add(spec.pos);
+            else
+                wanted.add(spec.name);
+        }
+
+        Stream stream(file, wanted, sep);
+        const Schema &schema = stream.getSchema();
+        _checksum = checksum(file, schema, columns);
+
+        std::shared_ptr<std::vector<Buffers>> buffers = std::make_shared<std::vector<Buffers>>(columns.size());
+        _storage = buffers;
+
+        std::vector<unsigned int> positions;
+        for (unsigned int col = 0; col < columns.size(); col++)
+        {
+            const ColumnSpec &spec = columns[col];
+            unsigned int pos = spec.name.empty() ? spec.pos : schema.column(spec.name);
+            positions.push_back(pos);
+
+            Data data{};
+            data.name = schema.name(pos);
+            data.type = spec.type;
+            data.errors = 0;
+            if (data.type == eSTRING)
+                (*buffers)[col].offsets.push_back(0);
+            _columns.push_back(std::move(data));
+        }
+
+        // the buffers move around as they grow, so the pointers get set again before anyone reads them
+        auto point = [this, &buffers]()
+        {
+            for (unsigned int col = 0; col < _columns.size(); col++)
+            {
+                Data &data = _columns[col];
+                const Buffers &buf = (*buffers)[col];
+                data.bytes = buf.bytes.data();
+                data.offsets = buf.offsets.data();
+                data.doubles = buf.doubles.data();
+                data.ints = buf.ints.data();
+            }
+        };
+
+        for (const RowView &row : stream)
+        {
+            for (unsigned int col = 0; col < _columns.size(); col++)
+            {
+                Data &data = _columns[col];
+                Buffers &buf = (*buffers)[col];
+                std::string_view value = row[positions[col]];
+
+                switch (data.type)
+                {
+                    case eSTRING:
+                        buf.bytes.append(value.data(), value.size());
+                        buf.offsets.push_back(buf.bytes.size());
+                        break;
+                    case eINT64:
+                    {
+                        std::int64_t number = 0;
+                        if (toNumber(value, number) != std::errc())
+                            data.errors++;
+                        buf.ints.push_back(number);
+                        break;
+                    }
+                    case eDOUBLE:
+                    case eMONEY:
+                    {
+                        double number = 0.0;
+                        std::errc ec = data.type == eMONEY ? toMoney(value, number) : toNumber(value, number);
+                        if (ec != std::errc())
+                        {
+                            number = 0.0;
+                            data.errors++;
+                        }
+                        buf.doubles.push_back(number);
+                        break;
+                    }
+                }
+            }
+            _rows++;
+
+            if (each)
+            {
+                point();
+                each(*this, _rows - 1);
+            }
+        }
+        point();
+    }
+
+    namespace
+    {
+        const char snapshotMagic[8] = {'C', 'S', 'V', 'S', 'N', 'A', 'P', '2'};
+
+        template<typename T>
+        void writeValue(std::string &out, const T &value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        // arrays start on a multiple of 8 in the file, so the mapping can be read in place
+        template<typename T>
+        void writeArray(std::string &out, const T *values, std::size_t count)
+        {
+            out.append((8 - out.size() % 8) % 8, '\0');
+            if (count > 0)
+                out.append(reinterpret_cast<const char *>(values), count * sizeof(T));
+        }
+
+        // walks a snapshot mapping, throwing instead of reading past its end
+        class SnapshotReader
+        {
+
+        public:
+            explicit SnapshotReader(std::string_view data)
+                    : _data(data), _pos(0) {}
+
+            template<typename T>
+            T value()
+            {
+                T v;
+                std::memcpy(&v, take(sizeof(T)), sizeof(T));
+                return v;
+            }
+
+            // points into the mapping, nothing is copied
+            template<typename T>
+            const T *array(std::size_t count)
+            {
+                take((8 - _pos % 8) % 8);
+                if (count > (_data.size() - _pos) / sizeof(T))
+                    throw Error("truncated snapshot");
+                const char *p = take(count * sizeof(T));
+                if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) != 0)
+                    throw Error("misaligned snapshot");
+                return reinterpret_cast<const T *>(p);
+            }
+
+            std::string_view bytes(std::size_t count)
+            {
+                return std::string_view(take(count), count);
+            }
+
+        private:
+            const char *take(std::size_t count)
+            {
+                if (count > _data.size() - _pos)
+                    throw Error("truncated snapshot");
+                const char *p = _data.data() + _pos;
+                _pos += count;
+                return p;
+            }
+
+            std::string_view _data;
+            std::size_t _pos;
+        };
+    }
+
+    std::uint64_t Table::checksum(const std::string &file, const Schema &schema, const std::vector<ColumnSpec> &columns)
+    {
+        // FNV-1a over the header names, the resolved column list and the CSV's size and mtime,
+        // so an edit to the rows (not just the header) makes an old snapshot stale too
+        std::uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](std::string_view bytes)
+        {
+            for (unsigned char c : bytes)
+            {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            hash ^= 0xFF; // separator, so "ab","c" and "a","bc" differ
+            hash *= 1099511628211ULL;
+        };
+
+        for (const std::string &name : schema.names())
+            mix(name);
+        for (const ColumnSpec &spec : columns)
+        {
+            unsigned int pos = spec.name.empty() ? spec.pos : schema.column(spec.name);
+            mix(std::to_string(pos));
+            mix(std::to_string(static_cast<int>(spec.type)));
+        }
+
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(file, ec);
+        mix(std::to_string(ec ? 0 : size));
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file, ec);
+        mix(std::to_string(ec ? 0 : static_cast<long long>(time.time_since_epoch().count())));
+        return hash;
+    }
+
+    Table Table::open(const std::string &file, const std::vector<ColumnSpec> &columns, char sep, const RowHandler &each)
+    {
+        std::string snapshot = file + ".snap";
+        std::error_code ec;
+        Table table;
+        bool fresh = false;
+
+        if (std::filesystem::exists(snapshot, ec))
+        {
+            try
+            {
+                // only the header line of the CSV is read to check the snapshot still fits
+                Stream header(file, sep, 4096);
+                table = load(snapshot);
+                fresh = table._checksum == checksum(file, header.getSchema(), columns);
+            }
+            catch (const Error &)
+            {
+                // unreadable or stale snapshot, parse the CSV instead
+            }
+        }
+
+        if (fresh)
+        {
+            if (each)
+                for (std::size_t row = 0; row < table._rows; row++)
+                    each(table, row);
+            return table;
+        }
+
+        table = Table(file, columns, sep, each);
+        try
+        {
+            table.save(snapshot);
+        }
+        catch (const Error &)
+        {
+            // a read-only folder just means no snapshot next time
+        }
+        return table;
+    }
+
+    Table Table::load(const std::string &snapshot)
+    {
+        std::shared_ptr<MappedFile> map = std::make_shared<MappedFile>(snapshot);
+        SnapshotReader in(map->view());
+        Table table;
+        table._storage = map;
+
+        if (in.bytes(sizeof(snapshotMagic)) != std::string_view(snapshotMagic, sizeof(snapshotMagic)))
+            throw Error(std::string("not a snapshot: ").append(snapshot));
+
+        table._checksum = in.value<std::uint64_t>();
+        std::uint64_t rows = in.value<std::uint64_t>();
+        std::uint32_t count = in.value<std::uint32_t>();
+
+        // every column takes at least 8 bytes a row, so anything bigger is garbage
+        // (and would wrap rows + 1 below)
+        if (count == 0 || rows > map->size() / sizeof(std::uint64_t))
+            throw Error(std::string("corrupted snapshot: ").append(snapshot));
+        table._rows = static_cast<std::size_t>(rows);
+
+        for (std::uint32_t col = 0; col < count; col++)
+        {
+            Data data{};
+            data.type = static_cast<ColumnType>(in.value<std::uint32_t>());
+            data.name = std::string(in.bytes(in.value<std::uint32_t>()));
+            data.errors = in.value<std::uint64_t>();
+
+            switch (data.type)
+            {
+                case eSTRING:
+                {
+                    std::uint64_t size = in.value<std::uint64_t>();
+                    if (size > map->size())
+                        throw Error(std::string("corrupted snapshot: ").append(snapshot));
+                    data.bytes = in.bytes(static_cast<std::size_t>(size)).data();
+                    data.offsets = in.array<std::uint64_t>(table._rows + 1);
+                    for (std::size_t row = 0; row < table._rows; row++)
+                        if (data.offsets[row] > data.offsets[row + 1])
+                            throw Error(std::string("corrupted snapshot: ").append(snapshot));
+                    if (data.offsets[0] != 0 || data.offsets[table._rows] != size)
+                        throw Error(std::string("corrupted snapshot: ").append(snapshot));
+                    break;
+                }
+                case eINT64:
+                    data.ints = in.array<std::int64_t>(table._rows);
+                    break;
+                case eDOUBLE:
+                case eMONEY:
+                    data.doubles = in.array<double>(table._rows);
+                    break;
+                default:
+                    throw Error(std::string("corrupted snapshot: ").append(snapshot));
+            }
+            table._columns.push_back(std::move(data));
+        }
+
+        table._snapshot = true;
+        return table;
+    }
+
+    void Table::save(const std::string &snapshot) const
+    {
+        std::string out;
+        out.append(snapshotMagic, sizeof(snapshotMagic));
+        writeValue<std::uint64_t>(out, _checksum);
+        writeValue<std::uint64_t>(out, _rows);
+        writeValue<std::uint32_t>(out, _columns.size());
+
+        for (const Data &data : _columns)
+        {
+            writeValue<std::uint32_t>(out, data.type);
+            writeValue<std::uint32_t>(out, data.name.size());
+            out.append(data.name);
+            writeValue<std::uint64_t>(out, data.errors);
+
+            if (data.type == eSTRING)
+            {
+                writeValue<std::uint64_t>(out, data.offsets[_rows]);
+                out.append(data.bytes, data.offsets[_rows]);
+                writeArray(out, data.offsets, _rows + 1);
+            }
+            else if (data.type == eINT64)
+                writeArray(out, data.ints, _rows);
+            else
+                writeArray(out, data.doubles, _rows);
+        }
+
+        // same as Parser::writeAll : on the disk before the rename, then the rename itself
+        std::string temp = snapshot + ".tmp";
+        std::ofstream f(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        f.close();
+
+        std::error_code ec;
+        if (!f || !flushToDisk(temp))
+        {
+            std::filesystem::remove(temp, ec);
+            throw Error(std::string("Failed to write ").append(temp));
+        }
+
+        std::filesystem::rename(temp, snapshot, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temp, ec);
+            throw Error(std::string("Failed to replace ").append(snapshot));
+        }
+        flushDirectoryOf(snapshot);
+    }
+
+    bool Table::fromSnapshot() const
+    {
+        return _snapshot;
+    }
+
+    std::size_t Table::rowCount() const
+    {
+        return _rows;
+    }
+
+    unsigned int Table::columnCount() const
+    {
+        return _columns.size();
+    }
+
+    unsigned int Table::column(std::string_view name) const
+    {
+        for (unsigned int col = 0; col < _columns.size(); col++)
+            if (_columns[col].name == name)
+                return col;
+        throw Error(std::string("no column named ").append(name));
+    }
+
+    const std::string &Table::name(unsigned int col) const
+    {
+        return data(col).name;
+    }
+
+    ColumnType Table::type(unsigned int col) const
+    {
+        return data(col).type;
+    }
+
+    std::size_t Table::conversionErrors(unsigned int col) const
+    {
+        return data(col).errors;
+    }
+
+    std::string_view Table::str(unsigned int col, std::size_t row) const
+    {
+        const Data &d = data(col);
+
+        if (d.type != eSTRING)
+            throw Error("not a string column");
+        if (row >= _rows)
+            throw Error("can't return this row (doesn't exist)");
+        return std::string_view(d.bytes + d.offsets[row], d.offsets[row + 1] - d.offsets[row]);
+    }
+
+    const double *Table::doubles(unsigned int col) const
+    {
+        const Data &d = data(col);
+
+        if (d.type != eDOUBLE && d.type != eMONEY)
+            throw Error("not a floating point column");
+        return d.doubles;
+    }
+
+    const std::int64_t *Table::ints(unsigned int col) const
+    {
+        const Data &d = data(col);
+
+        if (d.type != eINT64)
+            throw Error("not an integer column");
+        return d.ints;
+    }
+
+    std::unordered_map<std::string_view, double> Table::sumBy(unsigned int keyCol, unsigned int valueCol) const
+    {
+        const Data &keys = data(keyCol);
+        const double *values = doubles(valueCol);
+        std::unordered_map<std::string_view, double> sums;
+
+        if (keys.type != eSTRING)
+            throw Error("not a string column");
+
+        for (std::size_t row = 0; row < _rows; row++)
+            sums[std::string_view(keys.bytes + keys.offsets[row], keys.offsets[row + 1] - keys.offsets[row])] += values[row];
+        return sums;
+    }
+
+    const Table::Data &Table::data(unsigned int col) const
+    {
+        if (col >= _columns.size())
+            throw Error("can't return this column (doesn't exist)");
+        return _columns[col];
+    }
 }
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <ctime>
 #include <vector>
+#include <string_view>
 
 #include "CSVparser.cpp"
 
@@ -19,9 +20,6 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
-
 // define a structure to hold bid information... not sure why we are using struct instead of a public class but ok
 struct Bid {
     /* The CSV contains the following fields:
@@ -60,6 +58,40 @@ void displayBid(const Bid& bid) {
          << bid.fund << endl;
 }
 
+/**
+ * Find a bid by id without printing or copying anything
+ *
+ * The bids get sorted by title, not id, so this is a straight linear search.
+ *
+ * @param bids the bids to look through
+ * @param bidId the bid id to look for
+ * @return the bid, or nullptr if it isn't there. Only good until the vector changes.
+ */
+const Bid* findBid(const vector<Bid>& bids, string_view bidId) {
+    for (const Bid& bid : bids) {
+        if (bid.bidId == bidId) {
+            return &bid;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Remove a bid by id, keeping the order of the others
+ *
+ * @param bids the bids to remove from
+ * @param bidId the bid id to remove
+ * @return true if it was there
+ */
+bool eraseBid(vector<Bid>& bids, string_view bidId) {
+    const Bid* found = findBid(bids, bidId);
+    if (found == nullptr) {
+        return false;
+    }
+    bids.erase(bids.begin() + (found - bids.data()));
+    return true;
+}
+
 /**
  * Prompt user for bid information using console (std::in)
  *
@@ -82,7 +114,7 @@ Bid getBid() {
     cin.ignore();
     string strAmount;
     getline(cin, strAmount);
-    bid.amount = strToDouble(strAmount, '$');
+    csv::toMoney(strAmount, bid.amount);
 
     return bid;
 }
@@ -99,24 +131,33 @@ vector<Bid> loadBids(const string& csvPath) {
     // Define a vector data structure to hold a collection of bids.
     vector<Bid> bids;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
-
     try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+        // initialize the CSV Parser using the given path
+        // only id, title, fund and winning bid get loaded (columns 1, 0, 8 and 4). The file is streamed
+        // and each bid gets added as soon as its row is read, while the columns are kept for a binary
+        // snapshot next to the CSV, so loading the same file again skips the parsing
+        auto add = [&bids](const csv::Table& file, size_t i) {
+            // a snapshot knows how many rows there are up front
+            if (i == 0 && file.fromSnapshot()) {
+                bids.reserve(file.rowCount());
+            }
+
             // Create a data structure and add to the collection of bids
             // Names ___ or ___ refer to the Dec 2016 sample data or the main eBid Monthly master data set
             Bid bid;
-            bid.bidId = file[i][1]; //ArticleID or Auction ID
-            bid.title = file[i][0]; //ArticleTitle or Auction Title
-            bid.fund = file[i][8]; //Fund or Auction Fee Subtotal ... shouldn't this be [19] for the big data set?
-            bid.amount = strToDouble(file[i][4], '$'); //WinningBid or Winning Bid
+            bid.bidId = file.str(0, i); //ArticleID or Auction ID
+            bid.title = file.str(1, i); //ArticleTitle or Auction Title
+            bid.fund = file.str(2, i); //Fund or Auction Fee Subtotal ... shouldn't this be [19] for the big data set?
+            bid.amount = file.doubles(3)[i]; //WinningBid or Winning Bid
 
             //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
 
             // push this bid to the end
             bids.push_back(bid);
+        };
+        csv::Table file = csv::Table::open(csvPath, {{1}, {0}, {8}, {4, csv::eMONEY}}, ',', add);
+        if (file.fromSnapshot()) {
+            cout << "Read from snapshot " << csvPath << ".snap" << endl;
         }
     } catch (csv::Error &e) {
         std::cerr << e.what() << std::endl;
@@ -240,43 +281,6 @@ void selectionSort(vector<Bid>& bids) {
     }
 }
 
-/**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
- *
- * credit: http://stackoverflow.com/a/24875936
- *
- * @param ch The character to strip out
- */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
-}
-
-//I might change the strToDouble function to the code below... otherwise there won't be conversion error reporting
-/*
- *  #include <cstdlib>  // for strtod
-    #include <string>
-
-    double strToDouble(const std::string& str, char ch) {
-        std::string cleanedStr = str;
-        cleanedStr.erase(std::remove(cleanedStr.begin(), cleanedStr.end(), ch), cleanedStr.end());
-
-        char* endPtr;
-        double result = strtod(cleanedStr.c_str(), &endPtr);
-
-        // Check for conversion errors
-        if (*endPtr != '\0') {
-            // Handle error: The conversion was incomplete or failed
-            // You may want to throw an exception or return a default value
-            throw std::invalid_argument("Invalid floating-point number: " + str);
-        }
-
-        return result;
-}
-
- */
-
 int main(int argc, char* argv[]) {
     // process command line arguments
     string csvPath;
@@ -304,6 +308,8 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Selection Sort All Bids" << endl;
         cout << "  4. Quick Sort All Bids" << endl;
+        cout << "  5. Find Bid" << endl;
+        cout << "  6. Remove Bid" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -376,6 +382,40 @@ int main(int argc, char* argv[]) {
 
                 break;
 
+            case 5: {
+                string bidId;
+                cout << "Enter Id: ";
+                cin >> bidId;
+
+                ticks = clock();
+                const Bid* found = findBid(bids, bidId);
+                ticks = clock() - ticks;
+
+                if (found != nullptr) {
+                    displayBid(*found);
+                } else {
+                    cout << "Bid Id " << bidId << " not found." << endl;
+                }
+                cout << "time: " << ticks << " clock ticks" << endl;
+                cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+                break;
+            }
+
+            case 6: {
+                string bidId;
+                cout << "Enter Id: ";
+                cin >> bidId;
+
+                if (eraseBid(bids, bidId)) {
+                    cout << "Successfully removed bid ID# " << bidId << endl;
+                } else {
+                    cout << "Bid Id " << bidId << " not found." << endl;
+                }
+
+                break;
+            }
+
         }
     }
 